@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "led_strip.h"
@@ -13,6 +15,26 @@ static const char *TAG = "Blink";
 */
 #define BLINK_GPIO CONFIG_BLINK_GPIO
 
+/* Minimum time between two refreshes of the strip */
+#define BLINK_MIN_PERIOD_MS (1000 / CONFIG_BLINK_MAX_RATE_HZ)
+
+typedef struct {
+    int r;
+    int g;
+    int b;
+    uint8_t on;             /* 0 or 1, BLINK_STOP asks the task to leave */
+} blink_color_t;
+
+#define BLINK_STOP  0xFF
+
+/* Mailbox of length one: only the latest color is ever waiting. Created by the first blink_start() and
+   never deleted, so a blink_set() racing blink_stop() can only leave a stale color, never touch freed memory */
+static QueueHandle_t blink_mailbox;
+static TaskHandle_t blink_task_handle;
+/* Given by the task on its way out, so blink_stop() never cuts a refresh short */
+static SemaphoreHandle_t blink_done;
+static volatile bool blink_stopping;
+
 void blink_led(led_strip_handle_t led_strip, int color_r, int color_g, int color_b, uint8_t s_led_state)
 {
     /* If the addressable LED is enabled */
@@ -39,11 +61,111 @@ led_strip_handle_t configure_led(void)
 
     led_strip_rmt_config_t rmt_config = {
         .resolution_hz = 10 * 1000 * 1000, // 10MHz
+#if CONFIG_BLINK_RMT_DMA
+        .flags.with_dma = true,
+#else
         .flags.with_dma = false,
+#endif
     };
     ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip));
     /* Set all LED off to clear all pixels */
     led_strip_clear(led_strip);
 
     return led_strip;
-}
\ No newline at end of file
+}
+
+static void blink_task(void *arg)
+{
+    led_strip_handle_t led_strip = (led_strip_handle_t) arg;
+    blink_color_t color;
+    blink_color_t shown = { .r = -1 };
+    TickType_t last_refresh = 0;
+
+    while (1) {
+        xQueueReceive(blink_mailbox, &color, portMAX_DELAY);
+
+        /* Cap the refresh rate; whatever arrives meanwhile replaces this color */
+        TickType_t elapsed = xTaskGetTickCount() - last_refresh;
+        if (color.on != BLINK_STOP && elapsed < pdMS_TO_TICKS(BLINK_MIN_PERIOD_MS)) {
+            vTaskDelay(pdMS_TO_TICKS(BLINK_MIN_PERIOD_MS) - elapsed);
+            xQueueReceive(blink_mailbox, &color, 0);
+        }
+
+        if (color.on == BLINK_STOP) {
+            break;
+        }
+
+        if (color.on == shown.on && (!color.on || (color.r == shown.r && color.g == shown.g && color.b == shown.b))) {
+            continue;
+        }
+
+        blink_led(led_strip, color.r, color.g, color.b, color.on);
+        shown = color;
+        last_refresh = xTaskGetTickCount();
+    }
+
+    xSemaphoreGive(blink_done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t blink_start(led_strip_handle_t led_strip)
+{
+    if (blink_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (blink_done == NULL) {
+        blink_done = xSemaphoreCreateBinary();
+    }
+    if (blink_mailbox == NULL) {
+        blink_mailbox = xQueueCreate(1, sizeof(blink_color_t));
+    }
+    if (blink_mailbox == NULL || blink_done == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Drop whatever a late blink_set() left behind during the last stop */
+    xQueueReset(blink_mailbox);
+    blink_stopping = false;
+    if (xTaskCreate(blink_task, "blink", 2048, led_strip, CONFIG_BLINK_TASK_PRIORITY, &blink_task_handle) != pdPASS) {
+        blink_stopping = true;
+        blink_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Blink task started, up to %d Hz", CONFIG_BLINK_MAX_RATE_HZ);
+    return ESP_OK;
+}
+
+void blink_set(int color_r, int color_g, int color_b, uint8_t s_led_state)
+{
+    blink_color_t color = {
+        .r = color_r,
+        .g = color_g,
+        .b = color_b,
+        .on = s_led_state != 0,
+    };
+
+    /* Never blocks: the older color, if not shown yet, is simply dropped */
+    if (blink_mailbox != NULL && !blink_stopping) {
+        xQueueOverwrite(blink_mailbox, &color);
+    }
+}
+
+void blink_stop(void)
+{
+    if (blink_task_handle == NULL) {
+        return;
+    }
+
+    const blink_color_t stop = { .on = BLINK_STOP };
+
+    /* A blink_set() already past its check can still overwrite the stop value, so it is resent
+       until the task answers; the wait covers a rate-capped delay plus one refresh */
+    blink_stopping = true;
+    do {
+        xQueueOverwrite(blink_mailbox, &stop);
+    } while (xSemaphoreTake(blink_done, pdMS_TO_TICKS(BLINK_MIN_PERIOD_MS + 100)) != pdTRUE);
+
+    blink_task_handle = NULL;
+}
@@ -4,4 +4,11 @@ void blink_led(led_strip_handle_t led_strip, int color_r, int color_g, int color
 
 led_strip_handle_t configure_led(void);
 
+/* Background LED output: blink_set() leaves the color in a mailbox and returns at once,
+   a low-priority task shows the latest one at most CONFIG_BLINK_MAX_RATE_HZ times a second */
+esp_err_t blink_start(led_strip_handle_t led_strip);
 
+void blink_set(int color_r, int color_g, int color_b, uint8_t s_led_state);
+
+/* Lets the refresh in progress finish, then ends the task */
+void blink_stop(void);
@@ -6,18 +6,17 @@
 
 #include <string.h>
 #include <stdio.h>
-#include <math.h>
-#include <time.h>
-#include <sys/time.h>
 #include "esp_system.h"
 #include "esp_check.h"
 #include "esp_rom_sys.h"
+#include "esp_timer.h"
 #include "icm42670.h"
+#include "icm42670_filter.h"
+#include "neo_i2c.h"
 
 #define I2C_CLK_SPEED 400000
 
 #define ALPHA                       0.99f        /*!< Weight of gyroscope */
-#define RAD_TO_DEG                  57.27272727f /*!< Radians to degrees */
 
 #define ICM42607_ID 0x60
 #define ICM42670_ID 0x67
@@ -44,24 +43,89 @@
 #define ACCE_FS_4G_SENSITIVITY  (8192)
 #define ACCE_FS_2G_SENSITIVITY  (16384)
 
+/* FIFO bits */
+#define SIGNAL_PATH_RESET_FIFO_FLUSH    (1 << 2)
+#define FIFO_CONFIG1_BYPASS             (1 << 0)
+#define FIFO_CONFIG1_STOP_ON_FULL       (1 << 1)
+#define FIFO_CONFIG5_ACCEL_EN           (1 << 0)
+#define FIFO_CONFIG5_GYRO_EN            (1 << 1)
+#define FIFO_CONFIG5_TMST_FSYNC_EN      (1 << 2)
+#define TMST_CONFIG1_TMST_EN            (1 << 0)
+#define FIFO_CONFIG5_WM_GT_TH           (1 << 5)
+#define FIFO_HEADER_MSG                 (1 << 7)
+#define FIFO_HEADER_ACCEL               (1 << 6)
+#define FIFO_HEADER_GYRO                (1 << 5)
+#define FIFO_HEADER_20                  (1 << 4)
+#define FIFO_HEADER_TMST                (3 << 2)
+#define FIFO_HEADER_TMST_ODR            (2 << 2)  /*!< Packet carries the ODR timestamp */
+#define FIFO_PACKET_SHORT_SIZE          8    /*!< Accelerometer or gyroscope only */
+#define FIFO_PACKET_HIRES_SIZE          20
+
+/* Interrupt bits */
+#define INT_CONFIG_INT1_MASK            0x07
+#define INT_CONFIG_INT1_LATCHED         (1 << 2)
+#define INT_CONFIG_INT1_PUSH_PULL       (1 << 1)
+#define INT_CONFIG_INT1_ACTIVE_HIGH     (1 << 0)
+#define INT_SOURCE0_DRDY_INT1_EN        (1 << 3)
+#define INT_SOURCE0_FIFO_THS_INT1_EN    (1 << 2)
+#define INT_STATUS_DRDY_DATA_RDY        (1 << 0)
+#define INT_STATUS_FIFO_THS             (1 << 2)
+#define INT_STATUS_FIFO_FULL            (1 << 1)
+#define INT_SOURCE1_WOM_INT1_EN         0x07 /*!< WOM_Z, WOM_Y and WOM_X */
+#define INT_STATUS2_WOM_X               (1 << 2)
+#define INT_STATUS2_WOM_Y               (1 << 1)
+#define INT_STATUS2_WOM_Z               (1 << 0)
+#define WOM_CONFIG_EN                   (1 << 0)
+#define WOM_CONFIG_MODE_PREVIOUS        (1 << 1)
+#define WOM_CONFIG_INT_MODE_AND         (1 << 2)
+#define WOM_CONFIG_INT_DUR_SHIFT        3
+
 /*******************************************************************************
 * Types definitions
 *******************************************************************************/
 
 typedef struct {
-    i2c_master_dev_handle_t i2c_handle;
-    uint32_t counter;
-    float dt;  /*!< delay time between two measurements, dt should be small (ms level) */
-    struct timeval *timer;
+    neo_i2c_dev_handle_t i2c_handle;
+    int64_t cf_last_us;     /*!< Time of the last icm42670_complimentory_filter() call, 0 before the first */
+    uint8_t *fifo_buf;      /*!< Burst buffer, allocated by icm42670_fifo_config() */
+    uint8_t fifo_packet;    /*!< Packet size for the configured FIFO content */
+    uint8_t fifo_content;   /*!< FIFO_CONFIG5 sensor enable bits */
+    bool fifo_anchored;     /*!< fifo_time_us maps the FIFO stream to esp_timer time */
+    bool fifo_tmst_valid;   /*!< fifo_tmst holds the timestamp of the last packet */
+    uint16_t fifo_tmst;     /*!< Raw 16-bit timestamp of the last packet, us */
+    int64_t fifo_time_us;   /*!< Unwrapped time of the last packet */
+    struct {
+        uint8_t pwr_mgmt0;
+        uint8_t gyro_config0;
+        uint8_t accel_config0;
+    } regs;                 /*!< Shadow of PWR_MGMT0, GYRO_CONFIG0 and ACCEL_CONFIG0 */
+    struct {
+        uint8_t pwr_mgmt0;
+        uint8_t accel_config0;
+    } wom_saved;            /*!< Restored by icm42670_wom_disable() */
+    float acce_scale;       /*!< g per LSB for the current full scale */
+    float gyro_scale;       /*!< dps per LSB for the current full scale */
+    uint8_t config_gen;     /*!< Bumped on every GYRO_CONFIG0 or ACCEL_CONFIG0 change */
+    struct {
+        uint16_t packets;   /*!< Packets still in the FIFO from before the change */
+        uint8_t config_gen;
+        float acce_scale;
+        float gyro_scale;
+        uint32_t period_us;
+    } fifo_old;             /*!< Decoding of the packets queued before icm42670_reconfigure() */
 } icm42670_dev_t;
 
 /*******************************************************************************
 * Function definitions
 *******************************************************************************/
 static esp_err_t icm42670_write(icm42670_handle_t sensor, const uint8_t reg_start_addr, const uint8_t *data_buf, const uint8_t data_len);
-static esp_err_t icm42670_read(icm42670_handle_t sensor, const uint8_t reg_start_addr, uint8_t *data_buf, const uint8_t data_len);
+static esp_err_t icm42670_read(icm42670_handle_t sensor, const uint8_t reg_start_addr, uint8_t *data_buf, const size_t data_len);
 
 static esp_err_t icm42670_get_raw_value(icm42670_handle_t sensor, uint8_t reg, icm42670_raw_value_t *value);
+static void icm42670_shadow_update(icm42670_dev_t *sens, uint8_t reg_start_addr, const uint8_t *data_buf, size_t data_len);
+static float icm42670_acce_fs_sensitivity(uint8_t acce_fs);
+static float icm42670_gyro_fs_sensitivity(uint8_t gyro_fs);
+static uint32_t icm42670_fifo_period_us(icm42670_dev_t *sens);
 
 /*******************************************************************************
 * Local variables
@@ -78,16 +142,10 @@ esp_err_t icm42670_create(i2c_master_bus_handle_t i2c_bus, const uint8_t dev_add
 
     // Allocate memory and init the driver object
     icm42670_dev_t *sensor = (icm42670_dev_t *) calloc(1, sizeof(icm42670_dev_t));
-    struct timeval *timer = (struct timeval *) calloc(1, sizeof(struct timeval));
-    ESP_RETURN_ON_FALSE(sensor != NULL && timer != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
-    sensor->timer = timer;
+    ESP_RETURN_ON_FALSE(sensor != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
 
     // Add new I2C device
-    const i2c_device_config_t i2c_dev_cfg = {
-        .device_address = dev_addr,
-        .scl_speed_hz = I2C_CLK_SPEED,
-    };
-    ESP_GOTO_ON_ERROR(i2c_master_bus_add_device(i2c_bus, &i2c_dev_cfg, &sensor->i2c_handle), err, TAG, "Failed to add new I2C device");
+    ESP_GOTO_ON_ERROR(neo_i2c_add_device(i2c_bus, "icm42670", dev_addr, I2C_CLK_SPEED, &sensor->i2c_handle), err, TAG, "Failed to add new I2C device");
     assert(sensor->i2c_handle);
 
     // Check device presence
@@ -95,6 +153,11 @@ esp_err_t icm42670_create(i2c_master_bus_handle_t i2c_bus, const uint8_t dev_add
     icm42670_get_deviceid(sensor, &dev_id);
     ESP_GOTO_ON_FALSE(dev_id == ICM42607_ID || dev_id == ICM42670_ID, ESP_ERR_NOT_FOUND, err, TAG, "Incorrect Device ID (0x%02x).", dev_id);
 
+    // Load the shadow registers, PWR_MGMT0 is followed by GYRO_CONFIG0 and ACCEL_CONFIG0
+    uint8_t regs[3];
+    ESP_GOTO_ON_ERROR(icm42670_read(sensor, ICM42670_PWR_MGMT0, regs, sizeof(regs)), err, TAG, "Failed to read configuration");
+    icm42670_shadow_update(sensor, ICM42670_PWR_MGMT0, regs, sizeof(regs));
+
     ESP_LOGD(TAG, "Found device %s, ID: 0x%02x", (dev_id == ICM42607_ID ? "ICM42607" : "ICM42670"), dev_id);
     *handle_ret = sensor;
     return ret;
@@ -109,11 +172,11 @@ void icm42670_delete(icm42670_handle_t sensor)
     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
 
     if (sens->i2c_handle) {
-        i2c_master_bus_rm_device(sens->i2c_handle);
+        neo_i2c_remove_device(sens->i2c_handle);
     }
 
-    if (sens->timer) {
-        free(sens->timer);
+    if (sens->fifo_buf) {
+        free(sens->fifo_buf);
     }
 
     free(sens);
@@ -146,96 +209,86 @@ esp_err_t icm42670_config(icm42670_handle_t sensor, const icm42670_cfg_t *config
     return icm42670_write(sensor, ICM42670_GYRO_CONFIG0, data, sizeof(data));
 }
 
-esp_err_t icm42670_acce_set_pwr(icm42670_handle_t sensor, icm42670_acce_pwr_t state)
+esp_err_t icm42670_reconfigure(icm42670_handle_t sensor, const icm42670_cfg_t *config, bool flush)
 {
-    esp_err_t ret = ESP_FAIL;
-    uint8_t data;
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
 
-    ret = icm42670_read(sensor, ICM42670_PWR_MGMT0, &data, 1);
-    if (ret == ESP_OK) {
-        data |= (state & 0x03);
+    assert(config != NULL);
 
-        ret = icm42670_write(sensor, ICM42670_PWR_MGMT0, &data, sizeof(data));
+    if (sens->fifo_buf == NULL) {
+        return icm42670_config(sensor, config);
     }
 
-    return ret;
+    if (!flush && sens->fifo_old.packets > 0) {
+        /* Only one boundary is tracked */
+        ESP_LOGW(TAG, "FIFO not read since the last change, flushing");
+        flush = true;
+    }
+
+    const uint8_t old_gen = sens->config_gen;
+    const float old_acce_scale = sens->acce_scale;
+    const float old_gyro_scale = sens->gyro_scale;
+    const uint32_t old_period_us = icm42670_fifo_period_us(sens);
+
+    ESP_RETURN_ON_ERROR(icm42670_config(sensor, config), TAG, "Failed to set configuration");
+
+    if (flush) {
+        return icm42670_fifo_flush(sensor);
+    }
+    if (sens->config_gen == old_gen) {
+        return ESP_OK;
+    }
+
+    /* The sensors need at least one new ODR period to store a packet at the new settings,
+     * so everything counted right after the write was taken at the old ones */
+    uint16_t available;
+    ESP_RETURN_ON_ERROR(icm42670_fifo_get_count(sensor, &available), TAG, "Get FIFO count error!");
+
+    sens->fifo_old.packets = (available + sens->fifo_packet - 1) / sens->fifo_packet;
+    sens->fifo_old.config_gen = old_gen;
+    sens->fifo_old.acce_scale = old_acce_scale;
+    sens->fifo_old.gyro_scale = old_gyro_scale;
+    sens->fifo_old.period_us = old_period_us;
+
+    return ESP_OK;
 }
 
-esp_err_t icm42670_gyro_set_pwr(icm42670_handle_t sensor, icm42670_gyro_pwr_t state)
+esp_err_t icm42670_acce_set_pwr(icm42670_handle_t sensor, icm42670_acce_pwr_t state)
 {
-    esp_err_t ret = ESP_FAIL;
-    uint8_t data;
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+    uint8_t data = (sens->regs.pwr_mgmt0 & ~0x03) | (state & 0x03);
 
-    ret = icm42670_read(sensor, ICM42670_PWR_MGMT0, &data, 1);
-    if (ret == ESP_OK) {
-        data |= ((state & 0x03) << 2);
+    return icm42670_write(sensor, ICM42670_PWR_MGMT0, &data, sizeof(data));
+}
 
-        ret = icm42670_write(sensor, ICM42670_PWR_MGMT0, &data, sizeof(data));
-    }
+esp_err_t icm42670_gyro_set_pwr(icm42670_handle_t sensor, icm42670_gyro_pwr_t state)
+{
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+    uint8_t data = (sens->regs.pwr_mgmt0 & ~(0x03 << 2)) | ((state & 0x03) << 2);
 
-    return ret;
+    return icm42670_write(sensor, ICM42670_PWR_MGMT0, &data, sizeof(data));
 }
 
 esp_err_t icm42670_get_acce_sensitivity(icm42670_handle_t sensor, float *sensitivity)
 {
-    esp_err_t ret = ESP_FAIL;
-    uint8_t acce_fs;
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
 
     assert(sensitivity != NULL);
 
-    *sensitivity = 0;
+    *sensitivity = icm42670_acce_fs_sensitivity((sens->regs.accel_config0 >> 5) & 0x03);
 
-    ret = icm42670_read(sensor, ICM42670_ACCEL_CONFIG0, &acce_fs, 1);
-    if (ret == ESP_OK) {
-        acce_fs = (acce_fs >> 5) & 0x03;
-        switch (acce_fs) {
-        case ACCE_FS_16G:
-            *sensitivity = ACCE_FS_16G_SENSITIVITY;
-            break;
-        case ACCE_FS_8G:
-            *sensitivity = ACCE_FS_8G_SENSITIVITY;
-            break;
-        case ACCE_FS_4G:
-            *sensitivity = ACCE_FS_4G_SENSITIVITY;
-            break;
-        case ACCE_FS_2G:
-            *sensitivity = ACCE_FS_2G_SENSITIVITY;
-            break;
-        }
-    }
-
-    return ret;
+    return ESP_OK;
 }
 
 esp_err_t icm42670_get_gyro_sensitivity(icm42670_handle_t sensor, float *sensitivity)
 {
-    esp_err_t ret = ESP_FAIL;
-    uint8_t gyro_fs;
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
 
     assert(sensitivity != NULL);
 
-    *sensitivity = 0;
-
-    ret = icm42670_read(sensor, ICM42670_GYRO_CONFIG0, &gyro_fs, 1);
-    if (ret == ESP_OK) {
-        gyro_fs = (gyro_fs >> 5) & 0x03;
-        switch (gyro_fs) {
-        case GYRO_FS_2000DPS:
-            *sensitivity = GYRO_FS_2000_SENSITIVITY;
-            break;
-        case GYRO_FS_1000DPS:
-            *sensitivity = GYRO_FS_1000_SENSITIVITY;
-            break;
-        case GYRO_FS_500DPS:
-            *sensitivity = GYRO_FS_500_SENSITIVITY;
-            break;
-        case GYRO_FS_250DPS:
-            *sensitivity = GYRO_FS_250_SENSITIVITY;
-            break;
-        }
-    }
+    *sensitivity = icm42670_gyro_fs_sensitivity((sens->regs.gyro_config0 >> 5) & 0x03);
 
-    return ret;
+    return ESP_OK;
 }
 
 esp_err_t icm42670_get_temp_raw_value(icm42670_handle_t sensor, uint16_t *value)
@@ -268,7 +321,7 @@ esp_err_t icm42670_get_gyro_raw_value(icm42670_handle_t sensor, icm42670_raw_val
 esp_err_t icm42670_get_acce_value(icm42670_handle_t sensor, icm42670_value_t *value)
 {
     esp_err_t ret;
-    float sensitivity;
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
     icm42670_raw_value_t raw_value;
 
     assert(value != NULL);
@@ -277,15 +330,12 @@ esp_err_t icm42670_get_acce_value(icm42670_handle_t sensor, icm42670_value_t *va
     value->y = 0;
     value->z = 0;
 
-    ret = icm42670_get_acce_sensitivity(sensor, &sensitivity);
-    ESP_RETURN_ON_ERROR(ret, TAG, "Get sensitivity error!");
-
     ret = icm42670_get_acce_raw_value(sensor, &raw_value);
     ESP_RETURN_ON_ERROR(ret, TAG, "Get raw value error!");
 
-    value->x = raw_value.x / sensitivity;
-    value->y = raw_value.y / sensitivity;
-    value->z = raw_value.z / sensitivity;
+    value->x = raw_value.x * sens->acce_scale;
+    value->y = raw_value.y * sens->acce_scale;
+    value->z = raw_value.z * sens->acce_scale;
 
     return ESP_OK;
 }
@@ -293,7 +343,7 @@ esp_err_t icm42670_get_acce_value(icm42670_handle_t sensor, icm42670_value_t *va
 esp_err_t icm42670_get_gyro_value(icm42670_handle_t sensor, icm42670_value_t *value)
 {
     esp_err_t ret;
-    float sensitivity;
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
     icm42670_raw_value_t raw_value;
 
     assert(value != NULL);
@@ -302,15 +352,12 @@ esp_err_t icm42670_get_gyro_value(icm42670_handle_t sensor, icm42670_value_t *va
     value->y = 0;
     value->z = 0;
 
-    ret = icm42670_get_gyro_sensitivity(sensor, &sensitivity);
-    ESP_RETURN_ON_ERROR(ret, TAG, "Get sensitivity error!");
-
     ret = icm42670_get_gyro_raw_value(sensor, &raw_value);
     ESP_RETURN_ON_ERROR(ret, TAG, "Get raw value error!");
 
-    value->x = raw_value.x / sensitivity;
-    value->y = raw_value.y / sensitivity;
-    value->z = raw_value.z / sensitivity;
+    value->x = raw_value.x * sens->gyro_scale;
+    value->y = raw_value.y * sens->gyro_scale;
+    value->z = raw_value.z * sens->gyro_scale;
 
     return ESP_OK;
 }
@@ -332,6 +379,331 @@ esp_err_t icm42670_get_temp_value(icm42670_handle_t sensor, float *value)
     return ESP_OK;
 }
 
+esp_err_t icm42670_get_sample(icm42670_handle_t sensor, icm42670_sample_t *sample)
+{
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+    uint8_t data[14];
+
+    assert(sample != NULL);
+
+    memset(sample, 0, sizeof(*sample));
+
+    /* TEMP_DATA, ACCEL_DATA and GYRO_DATA are contiguous */
+    ESP_RETURN_ON_ERROR(icm42670_read(sensor, ICM42670_TEMP_DATA, data, sizeof(data)), TAG, "Get raw value error!");
+    sample->timestamp_us = esp_timer_get_time();
+    sample->config_gen = sens->config_gen;
+
+    sample->temp = ((int16_t)((data[0] << 8) + data[1]) / 128.0f) + 25.0f;
+    sample->acce.x = (int16_t)((data[2] << 8) + data[3]) * sens->acce_scale;
+    sample->acce.y = (int16_t)((data[4] << 8) + data[5]) * sens->acce_scale;
+    sample->acce.z = (int16_t)((data[6] << 8) + data[7]) * sens->acce_scale;
+    sample->gyro.x = (int16_t)((data[8] << 8) + data[9]) * sens->gyro_scale;
+    sample->gyro.y = (int16_t)((data[10] << 8) + data[11]) * sens->gyro_scale;
+    sample->gyro.z = (int16_t)((data[12] << 8) + data[13]) * sens->gyro_scale;
+
+    return ESP_OK;
+}
+
+esp_err_t icm42670_fifo_config(icm42670_handle_t sensor, const icm42670_fifo_cfg_t *config)
+{
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+    uint8_t data[2];
+
+    assert(config != NULL);
+    ESP_RETURN_ON_FALSE(config->acce_en || config->gyro_en, ESP_ERR_INVALID_ARG, TAG, "No sensor enabled for the FIFO");
+
+    uint8_t packet = (config->acce_en && config->gyro_en) ? ICM42670_FIFO_PACKET_SIZE : FIFO_PACKET_SHORT_SIZE;
+    uint32_t watermark = (uint32_t) config->watermark * packet;
+    ESP_RETURN_ON_FALSE(watermark < ICM42670_FIFO_SIZE, ESP_ERR_INVALID_ARG, TAG, "Watermark too large");
+
+    if (sens->fifo_buf == NULL) {
+        sens->fifo_buf = (uint8_t *) malloc(ICM42670_FIFO_SIZE);
+        ESP_RETURN_ON_FALSE(sens->fifo_buf != NULL, ESP_ERR_NO_MEM, TAG, "Not enough memory");
+    }
+
+    /* Bypass while the content is changed */
+    data[0] = FIFO_CONFIG1_BYPASS;
+    ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_FIFO_CONFIG1, data, 1), TAG, "Failed to bypass FIFO");
+
+    /* 1 us absolute ODR timestamps, stored in the 16 byte packets */
+    ESP_RETURN_ON_ERROR(icm42670_write_mreg_register(sensor, 1, ICM42670_MREG1_TMST_CONFIG1, TMST_CONFIG1_TMST_EN), TAG,
+                        "Failed to set TMST_CONFIG1");
+
+    uint8_t content = 0;
+    content |= config->acce_en ? FIFO_CONFIG5_ACCEL_EN : 0;
+    content |= config->gyro_en ? FIFO_CONFIG5_GYRO_EN : 0;
+    ESP_RETURN_ON_ERROR(icm42670_write_mreg_register(sensor, 1, ICM42670_MREG1_FIFO_CONFIG5,
+                                                     content | FIFO_CONFIG5_WM_GT_TH | FIFO_CONFIG5_TMST_FSYNC_EN), TAG,
+                        "Failed to set FIFO_CONFIG5");
+
+    data[0] = watermark & 0xFF;
+    data[1] = (watermark >> 8) & 0x0F;
+    ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_FIFO_CONFIG2, data, 2), TAG, "Failed to set watermark");
+
+    data[0] = config->stop_on_full ? FIFO_CONFIG1_STOP_ON_FULL : 0;
+    ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_FIFO_CONFIG1, data, 1), TAG, "Failed to enable FIFO");
+
+    sens->fifo_packet = packet;
+    sens->fifo_content = content;
+
+    return icm42670_fifo_flush(sensor);
+}
+
+esp_err_t icm42670_fifo_flush(icm42670_handle_t sensor)
+{
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+    uint8_t data = SIGNAL_PATH_RESET_FIFO_FLUSH;
+    esp_err_t ret = icm42670_write(sensor, ICM42670_SIGNAL_PATH_RESET, &data, 1);
+
+    /* The next packet starts a new stream */
+    sens->fifo_anchored = false;
+    sens->fifo_tmst_valid = false;
+    sens->fifo_old.packets = 0;
+
+    /* Flush takes 1.5 us to complete */
+    esp_rom_delay_us(2);
+
+    return ret;
+}
+
+esp_err_t icm42670_fifo_get_count(icm42670_handle_t sensor, uint16_t *count)
+{
+    esp_err_t ret = ESP_FAIL;
+    uint8_t data[2];
+
+    assert(count != NULL);
+
+    *count = 0;
+
+    ret = icm42670_read(sensor, ICM42670_FIFO_COUNTH, data, sizeof(data));
+    if (ret == ESP_OK) {
+        *count = (uint16_t)((data[0] << 8) + data[1]);
+    }
+
+    return ret;
+}
+
+esp_err_t icm42670_read_fifo(icm42670_handle_t sensor, icm42670_sample_t *samples, size_t max_samples, size_t *count)
+{
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+    uint16_t available;
+
+    assert(samples != NULL && count != NULL);
+
+    *count = 0;
+
+    ESP_RETURN_ON_FALSE(sens->fifo_buf != NULL, ESP_ERR_INVALID_STATE, TAG, "FIFO not configured");
+
+    ESP_RETURN_ON_ERROR(icm42670_fifo_get_count(sensor, &available), TAG, "Get FIFO count error!");
+
+    /* A full FIFO has dropped packets, so the previous timestamps no longer chain */
+    if (available + sens->fifo_packet > ICM42670_FIFO_SIZE) {
+        sens->fifo_anchored = false;
+        sens->fifo_tmst_valid = false;
+    }
+
+    size_t bytes = available;
+    if (bytes > ICM42670_FIFO_SIZE) {
+        bytes = ICM42670_FIFO_SIZE;
+    }
+    if (bytes > max_samples * sens->fifo_packet) {
+        bytes = max_samples * sens->fifo_packet;
+    }
+    /* Leave partial packets in the FIFO for the next read */
+    bytes -= bytes % sens->fifo_packet;
+    if (bytes == 0) {
+        return ESP_OK;
+    }
+
+    /* FIFO_DATA does not auto-increment, so one burst drains all the packets */
+    ESP_RETURN_ON_ERROR(icm42670_read(sensor, ICM42670_FIFO_DATA, sens->fifo_buf, bytes), TAG, "Read FIFO error!");
+    int64_t read_us = esp_timer_get_time();
+
+    const uint32_t new_period_us = icm42670_fifo_period_us(sens);
+    int64_t t = sens->fifo_anchored ? sens->fifo_time_us : 0;
+    size_t n = 0;
+    for (size_t off = 0; off < bytes && n < max_samples; n++) {
+        const uint8_t *p = &sens->fifo_buf[off];
+        uint8_t header = p[0];
+
+        if (header & FIFO_HEADER_MSG) {
+            /* Empty FIFO marker, nothing valid follows */
+            break;
+        }
+
+        size_t size = (header & FIFO_HEADER_20) ? FIFO_PACKET_HIRES_SIZE :
+                      ((header & FIFO_HEADER_ACCEL) && (header & FIFO_HEADER_GYRO)) ? ICM42670_FIFO_PACKET_SIZE :
+                      FIFO_PACKET_SHORT_SIZE;
+        if (off + size > bytes) {
+            break;
+        }
+
+        /* Packets queued before icm42670_reconfigure() keep the settings they were taken with */
+        const bool old = sens->fifo_old.packets > 0;
+        const float acce_scale = old ? sens->fifo_old.acce_scale : sens->acce_scale;
+        const float gyro_scale = old ? sens->fifo_old.gyro_scale : sens->gyro_scale;
+        const uint32_t period_us = old ? sens->fifo_old.period_us : new_period_us;
+
+        icm42670_sample_t *s = &samples[n];
+        memset(s, 0, sizeof(*s));
+        s->config_gen = old ? sens->fifo_old.config_gen : sens->config_gen;
+        p++;
+        if (header & FIFO_HEADER_ACCEL) {
+            s->acce.x = (int16_t)((p[0] << 8) + p[1]) * acce_scale;
+            s->acce.y = (int16_t)((p[2] << 8) + p[3]) * acce_scale;
+            s->acce.z = (int16_t)((p[4] << 8) + p[5]) * acce_scale;
+            p += 6;
+        }
+        if (header & FIFO_HEADER_GYRO) {
+            s->gyro.x = (int16_t)((p[0] << 8) + p[1]) * gyro_scale;
+            s->gyro.y = (int16_t)((p[2] << 8) + p[3]) * gyro_scale;
+            s->gyro.z = (int16_t)((p[4] << 8) + p[5]) * gyro_scale;
+            p += 6;
+        }
+        if (old) {
+            sens->fifo_old.packets--;
+        }
+        /* FIFO temperature is 8 bit: T = raw / 2 + 25 */
+        s->temp = ((int8_t) p[0] / 2.0f) + 25.0f;
+
+        /*
+         * The 1 us timestamp wraps every 65.536 ms, so a delta alone only holds up to 25 Hz. Below that
+         * the ODR period says how many wraps went by: the delta keeps the sub-period timing and gets the
+         * multiple of 65536 us that puts it closest to period_us. Packets without a timestamp take the ODR.
+         */
+        bool has_tmst = (header & FIFO_HEADER_TMST) == FIFO_HEADER_TMST_ODR;
+        uint16_t tmst = has_tmst ? (uint16_t)((p[1] << 8) + p[2]) : 0;
+        if (n > 0 || sens->fifo_anchored) {
+            uint32_t delta = (uint16_t)(tmst - sens->fifo_tmst);
+            if (has_tmst && sens->fifo_tmst_valid && delta != 0) {
+                if (period_us > delta + 0x8000) {
+                    delta += (period_us - delta + 0x8000) & ~0xFFFFU;
+                }
+                t += delta;
+            } else {
+                t += period_us;
+            }
+        }
+        s->timestamp_us = t;
+        sens->fifo_tmst = tmst;
+        sens->fifo_tmst_valid = has_tmst;
+
+        off += size;
+    }
+
+    if (n > 0) {
+        if (!sens->fifo_anchored) {
+            /* Anchor the newest packet to the time of the read, within one ODR period */
+            int64_t offset = read_us - t;
+            for (size_t i = 0; i < n; i++) {
+                samples[i].timestamp_us += offset;
+            }
+            t += offset;
+            sens->fifo_anchored = true;
+        }
+        sens->fifo_time_us = t;
+    }
+
+    *count = n;
+
+    return ESP_OK;
+}
+
+esp_err_t icm42670_int_config(icm42670_handle_t sensor, const icm42670_int_cfg_t *config)
+{
+    uint8_t data;
+
+    assert(config != NULL);
+
+    /* Keep the INT2 bits */
+    ESP_RETURN_ON_ERROR(icm42670_read(sensor, ICM42670_INT_CONFIG, &data, 1), TAG, "Failed to read INT_CONFIG");
+    data &= ~INT_CONFIG_INT1_MASK;
+    data |= config->latched ? INT_CONFIG_INT1_LATCHED : 0;
+    data |= config->push_pull ? INT_CONFIG_INT1_PUSH_PULL : 0;
+    data |= config->active_high ? INT_CONFIG_INT1_ACTIVE_HIGH : 0;
+    ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_INT_CONFIG, &data, 1), TAG, "Failed to set INT_CONFIG");
+
+    data = 0;
+    data |= config->drdy_en ? INT_SOURCE0_DRDY_INT1_EN : 0;
+    data |= config->fifo_ths_en ? INT_SOURCE0_FIFO_THS_INT1_EN : 0;
+
+    return icm42670_write(sensor, ICM42670_INT_SOURCE0, &data, 1);
+}
+
+esp_err_t icm42670_get_int_status(icm42670_handle_t sensor, uint8_t *status)
+{
+    esp_err_t ret = ESP_FAIL;
+    uint8_t data[3];
+
+    assert(status != NULL);
+
+    *status = 0;
+
+    /* INT_STATUS_DRDY, INT_STATUS and INT_STATUS2 are contiguous and clear on read */
+    ret = icm42670_read(sensor, ICM42670_INT_STATUS_DRDY, data, sizeof(data));
+    if (ret == ESP_OK) {
+        *status |= (data[0] & INT_STATUS_DRDY_DATA_RDY) ? ICM42670_INT_FLAG_DRDY : 0;
+        *status |= (data[1] & INT_STATUS_FIFO_THS) ? ICM42670_INT_FLAG_FIFO_THS : 0;
+        *status |= (data[1] & INT_STATUS_FIFO_FULL) ? ICM42670_INT_FLAG_FIFO_FULL : 0;
+        *status |= (data[2] & INT_STATUS2_WOM_X) ? ICM42670_INT_FLAG_WOM_X : 0;
+        *status |= (data[2] & INT_STATUS2_WOM_Y) ? ICM42670_INT_FLAG_WOM_Y : 0;
+        *status |= (data[2] & INT_STATUS2_WOM_Z) ? ICM42670_INT_FLAG_WOM_Z : 0;
+    }
+
+    return ret;
+}
+
+esp_err_t icm42670_wom_enable(icm42670_handle_t sensor, const icm42670_wom_cfg_t *config)
+{
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+    uint8_t data;
+
+    assert(config != NULL);
+    ESP_RETURN_ON_FALSE(config->duration >= 1 && config->duration <= 4, ESP_ERR_INVALID_ARG, TAG, "Invalid WoM duration");
+
+    sens->wom_saved.pwr_mgmt0 = sens->regs.pwr_mgmt0;
+    sens->wom_saved.accel_config0 = sens->regs.accel_config0;
+
+    /* Low-power accelerometer only */
+    data = (sens->regs.accel_config0 & 0xF0) | (config->odr & 0x0F);
+    ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_ACCEL_CONFIG0, &data, 1), TAG, "Failed to set accelerometer ODR");
+    ESP_RETURN_ON_ERROR(icm42670_gyro_set_pwr(sensor, GYRO_PWR_OFF), TAG, "Failed to stop gyroscope");
+    ESP_RETURN_ON_ERROR(icm42670_acce_set_pwr(sensor, ACCE_PWR_LOWPOWER), TAG, "Failed to set accelerometer low-power");
+    esp_rom_delay_us(1000);
+
+    ESP_RETURN_ON_ERROR(icm42670_write_mreg_register(sensor, 1, ICM42670_MREG1_ACCEL_WOM_X_THR, config->thr_x), TAG,
+                        "Failed to set WoM X threshold");
+    ESP_RETURN_ON_ERROR(icm42670_write_mreg_register(sensor, 1, ICM42670_MREG1_ACCEL_WOM_Y_THR, config->thr_y), TAG,
+                        "Failed to set WoM Y threshold");
+    ESP_RETURN_ON_ERROR(icm42670_write_mreg_register(sensor, 1, ICM42670_MREG1_ACCEL_WOM_Z_THR, config->thr_z), TAG,
+                        "Failed to set WoM Z threshold");
+    esp_rom_delay_us(1000);
+
+    data = INT_SOURCE1_WOM_INT1_EN;
+    ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_INT_SOURCE1, &data, 1), TAG, "Failed to route WoM to INT1");
+
+    data = WOM_CONFIG_EN | ((config->duration - 1) << WOM_CONFIG_INT_DUR_SHIFT);
+    data |= config->all_axes ? WOM_CONFIG_INT_MODE_AND : 0;
+    data |= config->compare_previous ? WOM_CONFIG_MODE_PREVIOUS : 0;
+
+    return icm42670_write(sensor, ICM42670_WOM_CONFIG, &data, 1);
+}
+
+esp_err_t icm42670_wom_disable(icm42670_handle_t sensor)
+{
+    icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+    uint8_t data = 0;
+
+    ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_WOM_CONFIG, &data, 1), TAG, "Failed to disable WoM");
+    ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_INT_SOURCE1, &data, 1), TAG, "Failed to unroute WoM");
+
+    data = sens->wom_saved.accel_config0;
+    ESP_RETURN_ON_ERROR(icm42670_write(sensor, ICM42670_ACCEL_CONFIG0, &data, 1), TAG, "Failed to restore ODR");
+    data = sens->wom_saved.pwr_mgmt0;
+
+    return icm42670_write(sensor, ICM42670_PWR_MGMT0, &data, 1);
+}
+
 /*******************************************************************************
 * Private functions
 *******************************************************************************/
@@ -357,6 +729,82 @@ static esp_err_t icm42670_get_raw_value(icm42670_handle_t sensor, uint8_t reg, i
     return ret;
 }
 
+static float icm42670_acce_fs_sensitivity(uint8_t acce_fs)
+{
+    switch (acce_fs) {
+    case ACCE_FS_16G:
+        return ACCE_FS_16G_SENSITIVITY;
+    case ACCE_FS_8G:
+        return ACCE_FS_8G_SENSITIVITY;
+    case ACCE_FS_4G:
+        return ACCE_FS_4G_SENSITIVITY;
+    case ACCE_FS_2G:
+        return ACCE_FS_2G_SENSITIVITY;
+    }
+
+    return 0;
+}
+
+static float icm42670_gyro_fs_sensitivity(uint8_t gyro_fs)
+{
+    switch (gyro_fs) {
+    case GYRO_FS_2000DPS:
+        return GYRO_FS_2000_SENSITIVITY;
+    case GYRO_FS_1000DPS:
+        return GYRO_FS_1000_SENSITIVITY;
+    case GYRO_FS_500DPS:
+        return GYRO_FS_500_SENSITIVITY;
+    case GYRO_FS_250DPS:
+        return GYRO_FS_250_SENSITIVITY;
+    }
+
+    return 0;
+}
+
+static void icm42670_shadow_update(icm42670_dev_t *sens, uint8_t reg_start_addr, const uint8_t *data_buf, size_t data_len)
+{
+    bool changed = false;
+
+    for (size_t i = 0; i < data_len; i++) {
+        switch (reg_start_addr + i) {
+        case ICM42670_PWR_MGMT0:
+            sens->regs.pwr_mgmt0 = data_buf[i];
+            break;
+        case ICM42670_GYRO_CONFIG0:
+            changed |= sens->regs.gyro_config0 != data_buf[i];
+            sens->regs.gyro_config0 = data_buf[i];
+            sens->gyro_scale = 1.0f / icm42670_gyro_fs_sensitivity((data_buf[i] >> 5) & 0x03);
+            break;
+        case ICM42670_ACCEL_CONFIG0:
+            changed |= sens->regs.accel_config0 != data_buf[i];
+            sens->regs.accel_config0 = data_buf[i];
+            sens->acce_scale = 1.0f / icm42670_acce_fs_sensitivity((data_buf[i] >> 5) & 0x03);
+            break;
+        }
+    }
+
+    if (changed) {
+        sens->config_gen++;
+    }
+}
+
+static uint32_t icm42670_fifo_period_us(icm42670_dev_t *sens)
+{
+    /* ODR codes halve the rate from 1.6 kHz (5) on, lower codes are reserved */
+    uint8_t acce_odr = sens->regs.accel_config0 & 0x0F;
+    uint8_t gyro_odr = sens->regs.gyro_config0 & 0x0F;
+    uint32_t acce_us = 625U << (acce_odr > 5 ? acce_odr - 5 : 0);
+    uint32_t gyro_us = 625U << (gyro_odr > 5 ? gyro_odr - 5 : 0);
+
+    if (!(sens->fifo_content & FIFO_CONFIG5_GYRO_EN)) {
+        return acce_us;
+    }
+    if (!(sens->fifo_content & FIFO_CONFIG5_ACCEL_EN)) {
+        return gyro_us;
+    }
+    return acce_us < gyro_us ? acce_us : gyro_us;
+}
+
 static esp_err_t icm42670_write(icm42670_handle_t sensor, const uint8_t reg_start_addr, const uint8_t *data_buf, const uint8_t data_len)
 {
     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
@@ -365,53 +813,43 @@ static esp_err_t icm42670_write(icm42670_handle_t sensor, const uint8_t reg_star
     assert(data_len < 5);
     uint8_t write_buff[5] = {reg_start_addr};
     memcpy(&write_buff[1], data_buf, data_len);
-    return i2c_master_transmit(sens->i2c_handle, write_buff, data_len + 1, -1);
+    esp_err_t ret = neo_i2c_transmit(sens->i2c_handle, write_buff, data_len + 1, -1);
+    if (ret == ESP_OK) {
+        /* Every write goes through here, so the shadow never goes stale */
+        icm42670_shadow_update(sens, reg_start_addr, data_buf, data_len);
+    }
+
+    return ret;
 }
 
-static esp_err_t icm42670_read(icm42670_handle_t sensor, const uint8_t reg_start_addr, uint8_t *data_buf, const uint8_t data_len)
+static esp_err_t icm42670_read(icm42670_handle_t sensor, const uint8_t reg_start_addr, uint8_t *data_buf, const size_t data_len)
 {
     uint8_t reg_buff[] = {reg_start_addr};
     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
     assert(sens);
 
     /* Write register number and read data */
-    return i2c_master_transmit_receive(sens->i2c_handle, reg_buff, sizeof(reg_buff), data_buf, data_len, -1);
+    return neo_i2c_transmit_receive(sens->i2c_handle, reg_buff, sizeof(reg_buff), data_buf, data_len, -1);
 }
 
 esp_err_t icm42670_complimentory_filter(icm42670_handle_t sensor, const icm42670_value_t *const acce_value,
                                         const icm42670_value_t *const gyro_value, complimentary_angle_t *const complimentary_angle)
 {
-    float acce_angle[2];
-    float gyro_angle[2];
-    float gyro_rate[2];
     icm42670_dev_t *sens = (icm42670_dev_t *) sensor;
+    int64_t now = esp_timer_get_time();
+    icm42670_cf_t cf = {
+        .angle = *complimentary_angle,
+        .alpha = ALPHA,
+        .initialized = sens->cf_last_us != 0,
+    };
+    const icm42670_sample_t sample = {
+        .acce = *acce_value,
+        .gyro = *gyro_value,
+    };
 
-    sens->counter++;
-    if (sens->counter == 1) {
-        acce_angle[0] = (atan2(acce_value->y, acce_value->z) * RAD_TO_DEG);
-        acce_angle[1] = (atan2(acce_value->x, acce_value->z) * RAD_TO_DEG);
-        complimentary_angle->roll = acce_angle[0];
-        complimentary_angle->pitch = acce_angle[1];
-        gettimeofday(sens->timer, NULL);
-        return ESP_OK;
-    }
-
-    struct timeval now, dt_t;
-    gettimeofday(&now, NULL);
-    timersub(&now, sens->timer, &dt_t);
-    sens->dt = (float) (dt_t.tv_sec) + (float)dt_t.tv_usec / 1000000;
-    gettimeofday(sens->timer, NULL);
-
-    acce_angle[0] = (atan2(acce_value->y, acce_value->z) * RAD_TO_DEG);
-    acce_angle[1] = (atan2(acce_value->x, acce_value->z) * RAD_TO_DEG);
-
-    gyro_rate[0] = gyro_value->x;
-    gyro_rate[1] = gyro_value->y;
-    gyro_angle[0] = gyro_rate[0] * sens->dt;
-    gyro_angle[1] = gyro_rate[1] * sens->dt;
-
-    complimentary_angle->roll = (ALPHA * (complimentary_angle->roll + gyro_angle[0])) + ((1 - ALPHA) * acce_angle[0]);
-    complimentary_angle->pitch = (ALPHA * (complimentary_angle->pitch + gyro_angle[1])) + ((1 - ALPHA) * acce_angle[1]);
+    icm42670_cf_update(&cf, &sample, 1, (now - sens->cf_last_us) * 1e-6f);
+    sens->cf_last_us = now;
+    *complimentary_angle = cf.angle;
 
     return ESP_OK;
 }
@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include "icm42670_filter.h"
+
+#define PI_F            3.14159265f
+#define PI_2_F          1.57079633f
+#define RAD_TO_DEG_F    57.2957795f
+#define DEG_TO_RAD_F    0.0174532925f
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static float sample_dt(int64_t *last_us, const icm42670_sample_t *sample, float dt)
+{
+    if (sample->timestamp_us != 0 && *last_us != 0 && sample->timestamp_us > *last_us) {
+        dt = (sample->timestamp_us - *last_us) * 1e-6f;
+    }
+    *last_us = sample->timestamp_us;
+
+    return dt;
+}
+
+/*******************************************************************************
+* Public API functions
+*******************************************************************************/
+
+float icm42670_fast_atan2(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+
+    if (ax == 0.0f && ay == 0.0f) {
+        return 0.0f;
+    }
+
+    /* Odd polynomial for atan on [0, 1], the other octants by symmetry */
+    float z = (ax > ay) ? ay / ax : ax / ay;
+    float z2 = z * z;
+    float r = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f + z2 * (-0.0851330f + z2 * 0.0208351f))));
+
+    if (ay > ax) {
+        r = PI_2_F - r;
+    }
+    if (x < 0.0f) {
+        r = PI_F - r;
+    }
+
+    return (y < 0.0f) ? -r : r;
+}
+
+void icm42670_cf_init(icm42670_cf_t *cf, float alpha)
+{
+    cf->angle.roll = 0;
+    cf->angle.pitch = 0;
+    cf->alpha = alpha;
+    cf->initialized = false;
+    cf->last_us = 0;
+}
+
+void icm42670_cf_update(icm42670_cf_t *cf, const icm42670_sample_t *samples, size_t count, float dt)
+{
+    const float alpha = cf->alpha;
+    const float beta = 1.0f - alpha;
+    float roll = cf->angle.roll;
+    float pitch = cf->angle.pitch;
+    size_t i = 0;
+
+    if (!cf->initialized && count > 0) {
+        roll = icm42670_fast_atan2(samples[0].acce.y, samples[0].acce.z) * RAD_TO_DEG_F;
+        pitch = icm42670_fast_atan2(samples[0].acce.x, samples[0].acce.z) * RAD_TO_DEG_F;
+        cf->initialized = true;
+        cf->last_us = samples[0].timestamp_us;
+        i = 1;
+    }
+
+    for (; i < count; i++) {
+        const icm42670_sample_t *s = &samples[i];
+        float acce_roll = icm42670_fast_atan2(s->acce.y, s->acce.z) * RAD_TO_DEG_F;
+        float acce_pitch = icm42670_fast_atan2(s->acce.x, s->acce.z) * RAD_TO_DEG_F;
+        float h = sample_dt(&cf->last_us, s, dt);
+
+        roll = alpha * (roll + s->gyro.x * h) + beta * acce_roll;
+        pitch = alpha * (pitch + s->gyro.y * h) + beta * acce_pitch;
+    }
+
+    cf->angle.roll = roll;
+    cf->angle.pitch = pitch;
+}
+
+void icm42670_mahony_init(icm42670_mahony_t *filter, float kp, float ki)
+{
+    filter->q[0] = 1.0f;
+    filter->q[1] = 0.0f;
+    filter->q[2] = 0.0f;
+    filter->q[3] = 0.0f;
+    filter->kp = kp;
+    filter->ki = ki;
+    filter->bias[0] = 0.0f;
+    filter->bias[1] = 0.0f;
+    filter->bias[2] = 0.0f;
+    filter->last_us = 0;
+}
+
+void icm42670_mahony_update(icm42670_mahony_t *filter, const icm42670_sample_t *samples, size_t count, float dt)
+{
+    float q0 = filter->q[0], q1 = filter->q[1], q2 = filter->q[2], q3 = filter->q[3];
+
+    for (size_t i = 0; i < count; i++) {
+        const icm42670_sample_t *s = &samples[i];
+        float h = sample_dt(&filter->last_us, s, dt);
+        float half_h = 0.5f * h;
+        float gx = s->gyro.x * DEG_TO_RAD_F;
+        float gy = s->gyro.y * DEG_TO_RAD_F;
+        float gz = s->gyro.z * DEG_TO_RAD_F;
+        float ax = s->acce.x, ay = s->acce.y, az = s->acce.z;
+        float norm = ax * ax + ay * ay + az * az;
+
+        /* Free fall or a bad sample: integrate the gyroscope only */
+        if (norm > 0.0f) {
+            norm = 1.0f / sqrtf(norm);
+            ax *= norm;
+            ay *= norm;
+            az *= norm;
+
+            /* Gravity as seen by the current orientation */
+            float vx = 2.0f * (q1 * q3 - q0 * q2);
+            float vy = 2.0f * (q0 * q1 + q2 * q3);
+            float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+            float ex = ay * vz - az * vy;
+            float ey = az * vx - ax * vz;
+            float ez = ax * vy - ay * vx;
+
+            if (filter->ki > 0.0f) {
+                filter->bias[0] += filter->ki * ex * h;
+                filter->bias[1] += filter->ki * ey * h;
+                filter->bias[2] += filter->ki * ez * h;
+            }
+
+            gx += filter->kp * ex + filter->bias[0];
+            gy += filter->kp * ey + filter->bias[1];
+            gz += filter->kp * ez + filter->bias[2];
+        }
+
+        float qa = q0, qb = q1, qc = q2;
+        q0 += (-qb * gx - qc * gy - q3 * gz) * half_h;
+        q1 += (qa * gx + qc * gz - q3 * gy) * half_h;
+        q2 += (qa * gy - qb * gz + q3 * gx) * half_h;
+        q3 += (qa * gz + qb * gy - qc * gx) * half_h;
+
+        norm = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+        q0 *= norm;
+        q1 *= norm;
+        q2 *= norm;
+        q3 *= norm;
+    }
+
+    filter->q[0] = q0;
+    filter->q[1] = q1;
+    filter->q[2] = q2;
+    filter->q[3] = q3;
+}
+
+void icm42670_mahony_get_angle(const icm42670_mahony_t *filter, complimentary_angle_t *angle)
+{
+    const float *q = filter->q;
+    float sinp = 2.0f * (q[0] * q[2] - q[3] * q[1]);
+
+    if (sinp > 1.0f) {
+        sinp = 1.0f;
+    } else if (sinp < -1.0f) {
+        sinp = -1.0f;
+    }
+
+    angle->roll = icm42670_fast_atan2(2.0f * (q[0] * q[1] + q[2] * q[3]), 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2])) * RAD_TO_DEG_F;
+    /* asin(sinp) as atan2(sinp, cos), negated to match the sign of icm42670_cf_update() */
+    angle->pitch = -icm42670_fast_atan2(sinp, sqrtf(1.0f - sinp * sinp)) * RAD_TO_DEG_F;
+}
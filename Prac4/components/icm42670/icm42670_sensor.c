@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "esp_check.h"
+#include "icm42670_sensor.h"
+
+static const char *TAG = "ICM42670";
+
+static esp_err_t icm42670_sensor_init(neo_sensor_t *neo_sensor)
+{
+    ESP_RETURN_ON_ERROR(icm42670_acce_set_pwr(neo_sensor->ctx, ACCE_PWR_LOWNOISE), TAG, "Set accelerometer power error!");
+    ESP_RETURN_ON_ERROR(icm42670_gyro_set_pwr(neo_sensor->ctx, GYRO_PWR_LOWNOISE), TAG, "Set gyroscope power error!");
+
+    return ESP_OK;
+}
+
+static esp_err_t icm42670_sensor_fetch(neo_sensor_t *neo_sensor, neo_sample_t *samples, size_t max_samples, size_t *count)
+{
+    icm42670_sample_t imu;
+
+    if (max_samples < 3) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_RETURN_ON_ERROR(icm42670_get_sample(neo_sensor->ctx, &imu), TAG, "Get sample error!");
+
+    samples[0] = (neo_sample_t) { .timestamp_us = imu.timestamp_us, .kind = NEO_SAMPLE_ACCEL, .value = { imu.acce.x, imu.acce.y, imu.acce.z } };
+    samples[1] = (neo_sample_t) { .timestamp_us = imu.timestamp_us, .kind = NEO_SAMPLE_GYRO, .value = { imu.gyro.x, imu.gyro.y, imu.gyro.z } };
+    samples[2] = (neo_sample_t) { .timestamp_us = imu.timestamp_us, .kind = NEO_SAMPLE_TEMPERATURE, .value = { imu.temp } };
+    *count = 3;
+
+    return ESP_OK;
+}
+
+static esp_err_t icm42670_sensor_sleep(neo_sensor_t *neo_sensor)
+{
+    ESP_RETURN_ON_ERROR(icm42670_gyro_set_pwr(neo_sensor->ctx, GYRO_PWR_OFF), TAG, "Set gyroscope power error!");
+    ESP_RETURN_ON_ERROR(icm42670_acce_set_pwr(neo_sensor->ctx, ACCE_PWR_OFF), TAG, "Set accelerometer power error!");
+
+    return ESP_OK;
+}
+
+static const neo_sensor_ops_t icm42670_sensor_ops = {
+    .init = icm42670_sensor_init,
+    .fetch = icm42670_sensor_fetch,
+    .sleep = icm42670_sensor_sleep,
+};
+
+void icm42670_sensor_bind(icm42670_handle_t sensor, uint8_t id, neo_sensor_t *neo_sensor)
+{
+    *neo_sensor = (neo_sensor_t) {
+        .ops = &icm42670_sensor_ops,
+        .name = "icm42670",
+        .ctx = sensor,
+        .conversion_us = 0,
+        .id = id,
+    };
+}
@@ -10,6 +10,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include "driver/i2c_master.h"
 
 #define ICM42670_I2C_ADDRESS         0x68 /*!< I2C address with AD0 pin low */
@@ -21,13 +22,20 @@ extern "C" {
 #define ICM42670_APEX_CONFIG0        0x25 /*!< APEX configuration 0 */
 #define ICM42670_APEX_CONFIG1        0x26 /*!< APEX configuration 1 */
 #define ICM42670_WOM_CONFIG          0x27 /*!< Wake on Motion configuration */
+#define ICM42670_FIFO_CONFIG1        0x28 /*!< FIFO configuration 1 */
+#define ICM42670_FIFO_CONFIG2        0x29 /*!< FIFO watermark [7:0] */
+#define ICM42670_FIFO_CONFIG3        0x2A /*!< FIFO watermark [11:8] */
 #define ICM42670_INT_SOURCE0         0x2B /*!< Interrupt source 0 */
 #define ICM42670_INT_SOURCE1         0x2C /*!< Interrupt source 1 */
 #define ICM42670_INTF_CONFIG0        0x35 /*!< Interface configuration 0 */
 #define ICM42670_INTF_CONFIG1        0x36 /*!< Interface configuration 1 */
+#define ICM42670_INT_STATUS_DRDY     0x39 /*!< Data ready interrupt status */
 #define ICM42670_INT_STATUS          0x3A /*!< Interrupt status */
 #define ICM42670_INT_STATUS2         0x3B /*!< Interrupt status 2 */
 #define ICM42670_INT_STATUS3         0x3C /*!< Interrupt status 3 */
+#define ICM42670_FIFO_COUNTH         0x3D /*!< FIFO count high byte */
+#define ICM42670_FIFO_COUNTL         0x3E /*!< FIFO count low byte */
+#define ICM42670_FIFO_DATA           0x3F /*!< FIFO data port */
 #define ICM42670_BLK_SEL_W           0x79 /*! Select MREG1, MREG2, or MREG3 bank for writing */
 #define ICM42670_MADDR_W             0x7A /*! Set MREG* register address for writing */
 #define ICM42670_M_W                 0x7B /*! Write MREG* register value */
@@ -36,12 +44,28 @@ extern "C" {
 #define ICM42670_M_R                 0x7E /*! Read MREG* register value */
 
 // MREG1 Registers
+#define ICM42670_MREG1_TMST_CONFIG1     0x00 /*!< Timestamp configuration */
+#define ICM42670_MREG1_FIFO_CONFIG5     0x01 /*!< FIFO configuration 5 */
 #define ICM42670_MREG1_INT_CONFIG0      0x04 /*!< Interrupt configuration 0 */
 #define ICM42670_MREG1_INT_CONFIG1      0x05 /*!< Interrupt configuration 1 */
 #define ICM42670_MREG1_ACCEL_WOM_X_THR  0x4B /*!< WOM X threshold */
 #define ICM42670_MREG1_ACCEL_WOM_Y_THR  0x4C /*!< WOM Y threshold */
 #define ICM42670_MREG1_ACCEL_WOM_Z_THR  0x4D /*!< WOM Z threshold */
 
+#define ICM42670_FIFO_SIZE              2304 /*!< FIFO size in bytes */
+#define ICM42670_FIFO_PACKET_SIZE       16   /*!< Accelerometer + gyroscope + temperature + timestamp packet */
+
+/* Flags returned by icm42670_get_int_status() */
+#define ICM42670_INT_FLAG_DRDY          (1 << 0) /*!< New sample in the data registers */
+#define ICM42670_INT_FLAG_FIFO_THS      (1 << 1) /*!< FIFO count reached the watermark */
+#define ICM42670_INT_FLAG_FIFO_FULL     (1 << 2) /*!< FIFO full */
+#define ICM42670_INT_FLAG_WOM_X         (1 << 3) /*!< Wake on Motion on X */
+#define ICM42670_INT_FLAG_WOM_Y         (1 << 4) /*!< Wake on Motion on Y */
+#define ICM42670_INT_FLAG_WOM_Z         (1 << 5) /*!< Wake on Motion on Z */
+#define ICM42670_INT_FLAG_WOM           (ICM42670_INT_FLAG_WOM_X | ICM42670_INT_FLAG_WOM_Y | ICM42670_INT_FLAG_WOM_Z)
+
+#define ICM42670_WOM_THR_MG(mg)         ((uint8_t) (((mg) * 256 + 500) / 1000)) /*!< WoM threshold from mg, 3.9 mg per LSB */
+
 
 typedef enum {
     ACCE_FS_16G = 0,     /*!< Accelerometer full scale range is +/- 16g */
@@ -114,6 +138,39 @@ typedef struct {
     float z;
 } icm42670_value_t;
 
+typedef struct {
+    int64_t timestamp_us;   /*!< Sample time in esp_timer time base */
+    icm42670_value_t acce;  /*!< Accelerometer in g */
+    icm42670_value_t gyro;  /*!< Gyroscope in degrees per second */
+    float temp;             /*!< Temperature in degrees Celsius */
+    uint8_t config_gen;     /*!< Full scale and ODR generation, changes with every new configuration */
+} icm42670_sample_t;
+
+typedef struct {
+    uint16_t watermark;     /*!< Watermark in packets, 0 to leave it disabled */
+    bool acce_en;           /*!< Store accelerometer data */
+    bool gyro_en;           /*!< Store gyroscope data */
+    bool stop_on_full;      /*!< Drop new data when full instead of overwriting the oldest */
+} icm42670_fifo_cfg_t;
+
+typedef struct {
+    bool drdy_en;           /*!< Route data ready to INT1 */
+    bool fifo_ths_en;       /*!< Route FIFO watermark to INT1 */
+    bool active_high;       /*!< INT1 polarity */
+    bool push_pull;         /*!< INT1 push-pull instead of open drain */
+    bool latched;           /*!< Hold INT1 until the status is read instead of pulsing */
+} icm42670_int_cfg_t;
+
+typedef struct {
+    uint8_t thr_x;              /*!< X threshold, see ICM42670_WOM_THR_MG() */
+    uint8_t thr_y;              /*!< Y threshold */
+    uint8_t thr_z;              /*!< Z threshold */
+    icm42670_acce_odr_t odr;    /*!< Low-power accelerometer ODR while armed */
+    uint8_t duration;           /*!< Consecutive events over the threshold before the interrupt, 1 to 4 */
+    bool all_axes;              /*!< Require every axis over its threshold instead of any */
+    bool compare_previous;      /*!< Compare with the previous sample instead of the one taken when armed */
+} icm42670_wom_cfg_t;
+
 typedef struct {
     float roll;
     float pitch;
@@ -124,7 +181,7 @@ typedef void *icm42670_handle_t;
 /**
  * @brief Create and init sensor object
  *
- * @param[in]  i2c_bus    I2C bus handle. Obtained from i2c_new_master_bus()
+ * @param[in]  i2c_bus    I2C bus handle. Obtained from neo_i2c_bus_get()
  * @param[in]  dev_addr   I2C device address of sensor. Can be ICM42670_I2C_ADDRESS or ICM42670_I2C_ADDRESS_1
  * @param[out] handle_ret Handle to created ICM42670 driver object
  *
@@ -191,9 +248,29 @@ esp_err_t icm42670_gyro_set_pwr(icm42670_handle_t sensor, icm42670_gyro_pwr_t st
  */
 esp_err_t icm42670_config(icm42670_handle_t sensor, const icm42670_cfg_t *config);
 
+/**
+ * @brief Change full scale and ODR while streaming
+ *
+ * Without flush, packets already in the FIFO are still decoded with the previous settings
+ * and keep their config_gen, so the switch shows up as a config_gen change between two
+ * samples. Only one pending switch is tracked: if the FIFO was not read since the last
+ * one, it is flushed anyway. An overflow before the next read can shift the boundary.
+ *
+ * @param sensor object handle of icm42670
+ * @param config Accelerometer and gyroscope configuration structure
+ * @param flush drop the packets taken with the previous settings
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_reconfigure(icm42670_handle_t sensor, const icm42670_cfg_t *config, bool flush);
+
 /**
  * @brief Get accelerometer sensitivity
  *
+ * Taken from the driver's copy of ACCEL_CONFIG0, no bus access.
+ *
  * @param sensor object handle of icm42670
  * @param sensitivity accelerometer sensitivity
  *
@@ -206,6 +283,8 @@ esp_err_t icm42670_get_acce_sensitivity(icm42670_handle_t sensor, float *sensiti
 /**
  * @brief Get gyroscope sensitivity
  *
+ * Taken from the driver's copy of GYRO_CONFIG0, no bus access.
+ *
  * @param sensor object handle of icm42670
  * @param sensitivity gyroscope sensitivity
  *
@@ -287,9 +366,136 @@ esp_err_t icm42670_get_gyro_value(icm42670_handle_t sensor, icm42670_value_t *va
  */
 esp_err_t icm42670_get_temp_value(icm42670_handle_t sensor, float *value);
 
+/**
+ * @brief Read temperature, acceleration and gyroscope in a single transaction
+ *
+ * Uses the full scale cached by the driver.
+ *
+ * @param sensor object handle of icm42670
+ * @param sample scaled sample
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_get_sample(icm42670_handle_t sensor, icm42670_sample_t *sample);
+
+/**
+ * @brief Configure and enable the FIFO
+ *
+ * The FIFO is flushed afterwards. Accelerometer or gyroscope must be powered on, as MREG
+ * registers are not reachable while the chip sleeps.
+ *
+ * @param sensor object handle of icm42670
+ * @param config FIFO configuration
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG No sensor enabled or watermark larger than the FIFO
+ *     - ESP_ERR_NO_MEM Not enough memory for the transfer buffer
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_fifo_config(icm42670_handle_t sensor, const icm42670_fifo_cfg_t *config);
+
+/**
+ * @brief Discard the FIFO content
+ *
+ * @param sensor object handle of icm42670
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_fifo_flush(icm42670_handle_t sensor);
+
+/**
+ * @brief Get the number of bytes stored in the FIFO
+ *
+ * @param sensor object handle of icm42670
+ * @param count bytes in the FIFO
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_fifo_get_count(icm42670_handle_t sensor, uint16_t *count);
+
+/**
+ * @brief Read the FIFO in a single burst and decode it
+ *
+ * Reads as many whole packets as fit in samples. Disabled sensors read as 0.
+ * Sample times follow the FIFO hardware timestamps, or the ODR when the packets carry none,
+ * and are anchored to esp_timer time on the first read after a flush or an overflow.
+ *
+ * @param sensor object handle of icm42670
+ * @param samples buffer for the decoded samples, oldest first
+ * @param max_samples length of samples
+ * @param count number of decoded samples
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE FIFO not configured
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_read_fifo(icm42670_handle_t sensor, icm42670_sample_t *samples, size_t max_samples, size_t *count);
+
+/**
+ * @brief Configure the INT1 pin and the sources routed to it
+ *
+ * @param sensor object handle of icm42670
+ * @param config INT1 configuration
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_int_config(icm42670_handle_t sensor, const icm42670_int_cfg_t *config);
+
+/**
+ * @brief Read and clear the interrupt status, Wake on Motion included
+ *
+ * @param sensor object handle of icm42670
+ * @param status ICM42670_INT_FLAG_* bits
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_get_int_status(icm42670_handle_t sensor, uint8_t *status);
+
+/**
+ * @brief Arm Wake on Motion on INT1
+ *
+ * Turns the gyroscope off and the accelerometer to low-power mode at config->odr.
+ * Power and ODR are saved and restored by icm42670_wom_disable().
+ *
+ * @param sensor object handle of icm42670
+ * @param config Wake on Motion configuration
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Duration out of range
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_wom_enable(icm42670_handle_t sensor, const icm42670_wom_cfg_t *config);
+
+/**
+ * @brief Disarm Wake on Motion and restore the power mode and ODR in use before arming it
+ *
+ * @param sensor object handle of icm42670
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_FAIL Fail
+ */
+esp_err_t icm42670_wom_disable(icm42670_handle_t sensor);
+
 /**
  * @brief use complimentory filter to caculate roll and pitch
  *
+ * One-sample wrapper around icm42670_cf_update(), dt is the time since the previous call.
+ * For FIFO batches use icm42670_filter.h directly.
+ *
  * @param acce_value accelerometer measurements
  * @param gyro_value gyroscope measurements
  * @param complimentary_angle complimentary angle
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "icm42670.h"
+
+typedef struct {
+    complimentary_angle_t angle;    /*!< Roll and pitch in degrees */
+    float alpha;                    /*!< Weight of the gyroscope, 0 to 1 */
+    bool initialized;               /*!< false until the first sample seeds the angle from the accelerometer */
+    int64_t last_us;                /*!< Timestamp of the last sample, 0 if unknown */
+} icm42670_cf_t;
+
+typedef struct {
+    float q[4];                     /*!< Orientation quaternion, w x y z */
+    float kp;                       /*!< Proportional gain towards the accelerometer */
+    float ki;                       /*!< Integral gain, 0 disables gyroscope bias estimation */
+    float bias[3];                  /*!< Integral term, rad/s */
+    int64_t last_us;                /*!< Timestamp of the last sample, 0 if unknown */
+} icm42670_mahony_t;
+
+/**
+ * @brief Approximate atan2 in radians, single precision
+ *
+ * Maximum error is about 1e-5 rad.
+ */
+float icm42670_fast_atan2(float y, float x);
+
+/**
+ * @brief Reset a complementary filter
+ *
+ * @param cf filter state
+ * @param alpha weight of the gyroscope, 0.99 matches icm42670_complimentory_filter()
+ */
+void icm42670_cf_init(icm42670_cf_t *cf, float alpha);
+
+/**
+ * @brief Run the complementary filter over a batch of samples
+ *
+ * @param cf filter state, cf->angle holds the result
+ * @param samples samples, oldest first
+ * @param count number of samples
+ * @param dt seconds between samples, used only where a sample or its predecessor has no timestamp
+ */
+void icm42670_cf_update(icm42670_cf_t *cf, const icm42670_sample_t *samples, size_t count, float dt);
+
+/**
+ * @brief Reset a Mahony filter to the identity orientation
+ *
+ * @param filter filter state
+ * @param kp proportional gain, 1.0 is a reasonable start
+ * @param ki integral gain, 0 to skip bias estimation
+ */
+void icm42670_mahony_init(icm42670_mahony_t *filter, float kp, float ki);
+
+/**
+ * @brief Run the Mahony filter over a batch of samples
+ *
+ * @param filter filter state
+ * @param samples samples, oldest first
+ * @param count number of samples
+ * @param dt seconds between samples, used only where a sample or its predecessor has no timestamp
+ */
+void icm42670_mahony_update(icm42670_mahony_t *filter, const icm42670_sample_t *samples, size_t count, float dt);
+
+/**
+ * @brief Roll and pitch in degrees from the Mahony orientation
+ *
+ * @param filter filter state
+ * @param angle roll and pitch
+ */
+void icm42670_mahony_get_angle(const icm42670_mahony_t *filter, complimentary_angle_t *angle);
+
+#ifdef __cplusplus
+}
+#endif
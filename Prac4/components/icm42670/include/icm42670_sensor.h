@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "icm42670.h"
+#include "neo_sensor.h"
+
+/**
+ * @brief Expose an ICM42670 through the generic sensor interface
+ *
+ * init() powers accelerometer and gyroscope in low noise mode, fetch() returns
+ * an accelerometer, a gyroscope and a temperature record and sleep() powers
+ * both off. The device must already be configured with icm42670_config().
+ *
+ * @param sensor object handle of icm42670
+ * @param id identifier stamped on the produced samples
+ * @param[out] neo_sensor generic sensor to fill
+ */
+void icm42670_sensor_bind(icm42670_handle_t sensor, uint8_t id, neo_sensor_t *neo_sensor);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,225 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host benchmark of the batch attitude filters against the old per-sample
+ * icm42670_complimentory_filter(): double atan2 and two gettimeofday() per call.
+ *
+ * The trace is 60 s at 400 Hz of a roll swing at a fixed pitch tilt, with
+ * accelerometer and gyroscope noise and a constant gyroscope bias.
+ * Exits non-zero when an accuracy bound is missed; timings are only printed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "icm42670_filter.h"
+
+#define RATE_HZ         400
+#define SECONDS         60
+#define SAMPLES         (RATE_HZ * SECONDS)
+#define SETTLE          (RATE_HZ * 5)       /* Left out of the error figures */
+#define DT              (1.0f / RATE_HZ)
+#define ALPHA           0.99f
+#define BATCH           32                  /* About one FIFO watermark */
+#define REPEAT          20
+
+#define RAD_TO_DEG      57.27272727         /* The constant the old driver used */
+#define DEG             (M_PI / 180.0)
+
+#define ATAN2_MAX_ERR   2e-5                /* rad */
+#define CF_MAX_DIFF     0.02                /* deg, batch against the old filter; its 57.27 was 0.04% short */
+#define ROLL_MAX_RMS    1.0                 /* deg, against the true roll */
+
+static icm42670_sample_t trace[SAMPLES];
+static float truth_roll[SAMPLES];
+
+static uint32_t lcg = 12345;
+
+static float noise(float amplitude)
+{
+    /* Sum of four uniforms, close enough to a gaussian for a trace */
+    float sum = 0;
+    for (int i = 0; i < 4; i++) {
+        lcg = lcg * 1664525u + 1013904223u;
+        sum += (lcg >> 8) / 16777216.0f - 0.5f;
+    }
+    return sum * amplitude;
+}
+
+static void make_trace(void)
+{
+    const double pitch = 10 * DEG;
+
+    for (int i = 0; i < SAMPLES; i++) {
+        double t = (double) i / RATE_HZ;
+        double roll = 20 * DEG * sin(2 * M_PI * 0.5 * t);
+        double roll_rate = 20 * 2 * M_PI * 0.5 * cos(2 * M_PI * 0.5 * t);  /* deg/s */
+        icm42670_sample_t *s = &trace[i];
+
+        s->timestamp_us = (int64_t) i * 1000000 / RATE_HZ;
+        s->acce.x = -sin(pitch) + noise(0.02f);
+        s->acce.y = sin(roll) * cos(pitch) + noise(0.02f);
+        s->acce.z = cos(roll) * cos(pitch) + noise(0.02f);
+        s->gyro.x = roll_rate + 0.5f + noise(0.3f);
+        s->gyro.y = 0.5f + noise(0.3f);
+        s->gyro.z = noise(0.3f);
+        truth_roll[i] = roll / DEG;
+    }
+}
+
+/* icm42670_complimentory_filter() as it was, with the dt passed in so the result is comparable */
+static struct timeval legacy_timer;
+
+static void legacy_cf(const icm42670_sample_t *s, complimentary_angle_t *angle, float dt, int first)
+{
+    if (first) {
+        angle->roll = atan2(s->acce.y, s->acce.z) * RAD_TO_DEG;
+        angle->pitch = atan2(s->acce.x, s->acce.z) * RAD_TO_DEG;
+        gettimeofday(&legacy_timer, NULL);
+        return;
+    }
+
+    struct timeval now, dt_t;
+    gettimeofday(&now, NULL);
+    timersub(&now, &legacy_timer, &dt_t);
+    volatile float wall_dt = (float) dt_t.tv_sec + (float) dt_t.tv_usec / 1000000;
+    (void) wall_dt;
+    gettimeofday(&legacy_timer, NULL);
+
+    float acce_roll = atan2(s->acce.y, s->acce.z) * RAD_TO_DEG;
+    float acce_pitch = atan2(s->acce.x, s->acce.z) * RAD_TO_DEG;
+
+    angle->roll = (ALPHA * (angle->roll + s->gyro.x * dt)) + ((1 - ALPHA) * acce_roll);
+    angle->pitch = (ALPHA * (angle->pitch + s->gyro.y * dt)) + ((1 - ALPHA) * acce_pitch);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double atan2_max_error(void)
+{
+    double worst = 0;
+
+    for (int i = 0; i < 2000; i++) {
+        for (int j = 0; j < 2000; j++) {
+            float y = (i - 1000) / 250.0f;
+            float x = (j - 1000) / 250.0f;
+            double err = fabs(icm42670_fast_atan2(y, x) - atan2(y, x));
+            /* The branch cut: pi and -pi are the same angle */
+            if (err > M_PI) {
+                err = fabs(err - 2 * M_PI);
+            }
+            worst = err > worst ? err : worst;
+        }
+    }
+    return worst;
+}
+
+int main(void)
+{
+    static complimentary_angle_t legacy[SAMPLES];
+    static complimentary_angle_t batch[SAMPLES];
+    static complimentary_angle_t mahony[SAMPLES];
+    double t0, t_legacy, t_cf, t_mahony;
+    int failed = 0;
+
+    make_trace();
+
+    /* One sample per call, for an angle per sample: best of REPEAT runs */
+    t_legacy = t_cf = t_mahony = INFINITY;
+    for (int r = 0; r < REPEAT; r++) {
+        complimentary_angle_t angle = { 0 };
+        t0 = now_s();
+        for (int i = 0; i < SAMPLES; i++) {
+            legacy_cf(&trace[i], &angle, DT, i == 0);
+            legacy[i] = angle;
+        }
+        t_legacy = fmin(t_legacy, now_s() - t0);
+
+        icm42670_cf_t cf;
+        icm42670_cf_init(&cf, ALPHA);
+        t0 = now_s();
+        for (int i = 0; i < SAMPLES; i++) {
+            icm42670_cf_update(&cf, &trace[i], 1, DT);
+            batch[i] = cf.angle;
+        }
+        t_cf = fmin(t_cf, now_s() - t0);
+
+        icm42670_mahony_t mf;
+        icm42670_mahony_init(&mf, 1.0f, 0.05f);
+        t0 = now_s();
+        for (int i = 0; i < SAMPLES; i++) {
+            icm42670_mahony_update(&mf, &trace[i], 1, DT);
+            icm42670_mahony_get_angle(&mf, &mahony[i]);
+        }
+        t_mahony = fmin(t_mahony, now_s() - t0);
+    }
+
+    /* Batch calls alone, as the reader task makes them */
+    double t_cf_batch = INFINITY, t_mahony_batch = INFINITY;
+    for (int r = 0; r < REPEAT; r++) {
+        icm42670_cf_t cf;
+        icm42670_mahony_t mf;
+        icm42670_cf_init(&cf, ALPHA);
+        icm42670_mahony_init(&mf, 1.0f, 0.05f);
+
+        t0 = now_s();
+        for (int i = 0; i < SAMPLES; i += BATCH) {
+            icm42670_cf_update(&cf, &trace[i], SAMPLES - i < BATCH ? SAMPLES - i : BATCH, DT);
+        }
+        t_cf_batch = fmin(t_cf_batch, now_s() - t0);
+
+        t0 = now_s();
+        for (int i = 0; i < SAMPLES; i += BATCH) {
+            icm42670_mahony_update(&mf, &trace[i], SAMPLES - i < BATCH ? SAMPLES - i : BATCH, DT);
+        }
+        t_mahony_batch = fmin(t_mahony_batch, now_s() - t0);
+    }
+
+    double cf_diff = 0, cf_sq = 0, mahony_sq = 0, legacy_sq = 0;
+    for (int i = SETTLE; i < SAMPLES; i++) {
+        double d = fmax(fabs(batch[i].roll - legacy[i].roll), fabs(batch[i].pitch - legacy[i].pitch));
+        cf_diff = fmax(cf_diff, d);
+        legacy_sq += pow(legacy[i].roll - truth_roll[i], 2);
+        cf_sq += pow(batch[i].roll - truth_roll[i], 2);
+        mahony_sq += pow(mahony[i].roll - truth_roll[i], 2);
+    }
+    const int n = SAMPLES - SETTLE;
+    double legacy_rms = sqrt(legacy_sq / n), cf_rms = sqrt(cf_sq / n), mahony_rms = sqrt(mahony_sq / n);
+    double atan2_err = atan2_max_error();
+
+    printf("%d samples at %d Hz, batches of %d\n\n", SAMPLES, RATE_HZ, BATCH);
+    printf("%-28s %10s %12s\n", "", "ns/sample", "roll RMS deg");
+    printf("%-28s %10.1f %12.3f\n", "old per-sample filter", t_legacy * 1e9 / SAMPLES, legacy_rms);
+    printf("%-28s %10.1f %12.3f\n", "icm42670_cf_update", t_cf * 1e9 / SAMPLES, cf_rms);
+    printf("%-28s %10.1f %12s\n", "  batch calls only", t_cf_batch * 1e9 / SAMPLES, "");
+    printf("%-28s %10.1f %12.3f\n", "icm42670_mahony_update", t_mahony * 1e9 / SAMPLES, mahony_rms);
+    printf("%-28s %10.1f %12s\n", "  batch calls only", t_mahony_batch * 1e9 / SAMPLES, "");
+    printf("\nicm42670_fast_atan2 max error %.2e rad\n", atan2_err);
+    printf("batch cf against the old filter, max %.5f deg\n", cf_diff);
+
+    if (atan2_err > ATAN2_MAX_ERR) {
+        printf("FAIL: atan2 error over %.0e rad\n", ATAN2_MAX_ERR);
+        failed = 1;
+    }
+    if (cf_diff > CF_MAX_DIFF) {
+        printf("FAIL: batch cf drifts from the old filter by more than %.2f deg\n", CF_MAX_DIFF);
+        failed = 1;
+    }
+    if (cf_rms > ROLL_MAX_RMS || mahony_rms > ROLL_MAX_RMS) {
+        printf("FAIL: roll RMS over %.1f deg\n", ROLL_MAX_RMS);
+        failed = 1;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,3 +0,0 @@
-#include "driver/i2c_master.h"
-
-i2c_master_bus_handle_t  i2c_init(int I2C_SCL, int I2C_SDA);
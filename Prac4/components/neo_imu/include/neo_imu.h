@@ -0,0 +1,107 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "esp_event.h"
+#include "icm42670.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ESP_EVENT_DECLARE_BASE(NEO_IMU_EVENTS);
+
+enum {
+    NEO_IMU_DATA_READY,     /*!< Event data: newest icm42670_sample_t */
+    NEO_IMU_MOTION,         /*!< Event data: uint8_t ICM42670_INT_FLAG_WOM_* axes that fired */
+};
+
+/**
+ * @brief Receives the samples read after one interrupt, from the reader task
+ */
+typedef void (*neo_imu_sink_t)(const icm42670_sample_t *samples, size_t count, void *arg);
+
+typedef struct {
+    icm42670_handle_t imu;          /*!< Configured and powered on */
+    int int_gpio;                   /*!< GPIO wired to INT1 */
+    uint16_t watermark;             /*!< FIFO packets per interrupt, 0 for one data ready interrupt per sample */
+    neo_imu_sink_t sink;            /*!< Optional consumer of the samples */
+    void *sink_arg;                 /*!< Passed to sink */
+    esp_event_loop_handle_t loop;   /*!< Optional loop for NEO_IMU_EVENTS */
+} neo_imu_config_t;
+
+typedef struct {
+    uint32_t interrupts;            /*!< Wake-ups from INT1 */
+    uint32_t samples;               /*!< Samples delivered */
+    uint32_t timeouts;              /*!< Wake-ups from the watchdog */
+    uint32_t errors;                /*!< Failed bus reads */
+    uint32_t motions;               /*!< Wake on Motion events */
+} neo_imu_stats_t;
+
+typedef struct neo_imu *neo_imu_handle_t;
+
+/**
+ * @brief Route data ready (or the FIFO watermark) to INT1 and attach the GPIO interrupt
+ *
+ * The FIFO is configured here when watermark is not 0, so the sensors must be on already.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Missing IMU or watermark above CONFIG_NEO_IMU_FIFO_SAMPLES
+ *     - ESP_ERR_NO_MEM Not enough memory
+ *     - Others Error from the IMU or the GPIO driver
+ */
+esp_err_t neo_imu_create(const neo_imu_config_t *config, neo_imu_handle_t *handle_ret);
+
+/**
+ * @brief Start the reader task and enable the GPIO interrupt
+ */
+esp_err_t neo_imu_start(neo_imu_handle_t imu);
+
+/**
+ * @brief Stop streaming and wait for motion with the accelerometer in low-power mode
+ *
+ * Each Wake on Motion interrupt posts NEO_IMU_MOTION to the configured loop.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE Already armed
+ *     - Others Error from the IMU
+ */
+esp_err_t neo_imu_wom_start(neo_imu_handle_t imu, const icm42670_wom_cfg_t *config);
+
+/**
+ * @brief Disarm Wake on Motion and go back to streaming samples
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE Not armed
+ *     - Others Error from the IMU
+ */
+esp_err_t neo_imu_wom_stop(neo_imu_handle_t imu);
+
+/**
+ * @brief Change full scale and ODR without stopping the reader
+ *
+ * Runs between two reads of the task. Samples carry the config_gen they were taken with,
+ * see icm42670_reconfigure(). The watermark stays in packets, so its latency follows the ODR.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Missing config
+ *     - Others Error from the IMU
+ */
+esp_err_t neo_imu_reconfigure(neo_imu_handle_t imu, const icm42670_cfg_t *config, bool flush);
+
+/**
+ * @brief Counters of the reader task
+ */
+void neo_imu_get_stats(neo_imu_handle_t imu, neo_imu_stats_t *stats);
+
+/**
+ * @brief Stop the reader task, disable the IMU interrupts and free the reader
+ */
+void neo_imu_delete(neo_imu_handle_t imu);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "icm42670.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NEO_IMU_FEAT_AXES   6   // acce x y z, gyro x y z
+#define NEO_IMU_FEAT_FFT    3   // spectrum on the accelerometer axes only
+
+typedef struct {
+    float mean;
+    float rms;                  /*!< Around the mean */
+    float peak;                 /*!< Largest distance from the mean */
+    uint16_t zero_crossings;    /*!< Sign changes around the mean */
+} neo_imu_axis_features_t;
+
+/**
+ * @brief One record per window, what is kept of CONFIG_NEO_IMU_FEAT_WINDOW samples
+ */
+typedef struct {
+    int64_t timestamp_us;       /*!< First sample of the window */
+    int64_t duration_us;        /*!< First to last sample */
+    float band_hz;              /*!< Width of each band, bands split 0 to Nyquist */
+    neo_imu_axis_features_t axis[NEO_IMU_FEAT_AXES];
+    float band_energy[NEO_IMU_FEAT_FFT][CONFIG_NEO_IMU_FEAT_BANDS];  /*!< g^2 per band */
+} neo_imu_features_t;
+
+/**
+ * @brief Receives every record, from the task that feeds the samples
+ */
+typedef void (*neo_imu_features_sink_t)(const neo_imu_features_t *features, void *arg);
+
+typedef struct neo_imu_features *neo_imu_features_handle_t;
+
+/**
+ * @brief Create a feature extractor for a stream sampled at sample_rate_hz
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Missing sink or rate
+ *     - ESP_ERR_NO_MEM Not enough memory
+ */
+esp_err_t neo_imu_features_create(float sample_rate_hz, neo_imu_features_sink_t sink, void *sink_arg,
+                                  neo_imu_features_handle_t *handle_ret);
+
+/**
+ * @brief Append samples; the sink runs each time a window fills up
+ */
+void neo_imu_features_add(neo_imu_features_handle_t feat, const icm42670_sample_t *samples, size_t count);
+
+/**
+ * @brief Drop the partial window and free the extractor
+ */
+void neo_imu_features_delete(neo_imu_features_handle_t feat);
+
+#ifdef __cplusplus
+}
+#endif
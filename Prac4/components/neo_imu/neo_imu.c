@@ -0,0 +1,315 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "neo_imu.h"
+
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+ESP_EVENT_DEFINE_BASE(NEO_IMU_EVENTS);
+
+static const char *TAG = "neo_imu";
+
+struct neo_imu {
+    neo_imu_config_t config;
+    TaskHandle_t task;
+    SemaphoreHandle_t done;
+    SemaphoreHandle_t lock;         // a reconfiguration or WoM switch never lands in the middle of a read
+    volatile bool stop;
+    volatile bool wom;
+    neo_imu_stats_t stats;
+    icm42670_sample_t samples[CONFIG_NEO_IMU_FIFO_SAMPLES];
+};
+
+static void IRAM_ATTR neo_imu_isr(void *arg)
+{
+    struct neo_imu *imu = (struct neo_imu *) arg;
+    BaseType_t woken = pdFALSE;
+
+    vTaskNotifyGiveFromISR(imu->task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static esp_err_t neo_imu_int_route(struct neo_imu *imu, bool stream)
+{
+    // Latched: INT1 stays high until the task reads the status, so no event is lost between reads
+    const icm42670_int_cfg_t int_cfg = {
+        .drdy_en = stream && imu->config.watermark == 0,
+        .fifo_ths_en = stream && imu->config.watermark > 0,
+        .active_high = true,
+        .push_pull = true,
+        .latched = true,
+    };
+    return icm42670_int_config(imu->config.imu, &int_cfg);
+}
+
+esp_err_t neo_imu_create(const neo_imu_config_t *config, neo_imu_handle_t *handle_ret)
+{
+    esp_err_t ret;
+
+    if (config == NULL || config->imu == NULL || config->watermark > CONFIG_NEO_IMU_FIFO_SAMPLES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct neo_imu *imu = calloc(1, sizeof(struct neo_imu));
+    if (imu == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    imu->done = xSemaphoreCreateBinary();
+    imu->lock = xSemaphoreCreateMutex();
+    if (imu->done == NULL || imu->lock == NULL) {
+        if (imu->done != NULL) {
+            vSemaphoreDelete(imu->done);
+        }
+        if (imu->lock != NULL) {
+            vSemaphoreDelete(imu->lock);
+        }
+        free(imu);
+        return ESP_ERR_NO_MEM;
+    }
+    imu->config = *config;
+
+    if (config->watermark > 0) {
+        const icm42670_fifo_cfg_t fifo_cfg = {
+            .watermark = config->watermark,
+            .acce_en = true,
+            .gyro_en = true,
+        };
+        ret = icm42670_fifo_config(config->imu, &fifo_cfg);
+        if (ret != ESP_OK) {
+            goto err;
+        }
+    }
+
+    ret = neo_imu_int_route(imu, true);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+
+    const gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << config->int_gpio,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    ret = gpio_config(&io_conf);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+    gpio_intr_disable(config->int_gpio);
+
+    // Another component may have installed the service already
+    ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        goto err;
+    }
+    ret = gpio_isr_handler_add(config->int_gpio, neo_imu_isr, imu);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+
+    *handle_ret = imu;
+    return ESP_OK;
+
+err:
+    ESP_LOGE(TAG, "Create failed: %s", esp_err_to_name(ret));
+    neo_imu_int_route(imu, false);
+    vSemaphoreDelete(imu->done);
+    vSemaphoreDelete(imu->lock);
+    free(imu);
+    return ret;
+}
+
+static size_t neo_imu_read(struct neo_imu *imu)
+{
+    uint8_t status;
+    size_t count = 0;
+
+    // Reading the status releases INT1 for the next edge
+    if (icm42670_get_int_status(imu->config.imu, &status) != ESP_OK) {
+        imu->stats.errors++;
+        return 0;
+    }
+
+    if (status & ICM42670_INT_FLAG_WOM) {
+        uint8_t axes = status & ICM42670_INT_FLAG_WOM;
+
+        imu->stats.motions++;
+        if (imu->config.loop != NULL) {
+            esp_event_post_to(imu->config.loop, NEO_IMU_EVENTS, NEO_IMU_MOTION, &axes, sizeof(axes), 0);
+        }
+    }
+
+    if (imu->wom) {
+        return 0;
+    } else if (imu->config.watermark > 0) {
+        if (icm42670_read_fifo(imu->config.imu, imu->samples, CONFIG_NEO_IMU_FIFO_SAMPLES, &count) != ESP_OK) {
+            imu->stats.errors++;
+            return 0;
+        }
+    } else if (status & ICM42670_INT_FLAG_DRDY) {
+        if (icm42670_get_sample(imu->config.imu, &imu->samples[0]) != ESP_OK) {
+            imu->stats.errors++;
+            return 0;
+        }
+        count = 1;
+    }
+
+    return count;
+}
+
+static void neo_imu_task(void *arg)
+{
+    struct neo_imu *imu = (struct neo_imu *) arg;
+
+    while (!imu->stop) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_NEO_IMU_WATCHDOG_MS)) > 0) {
+            imu->stats.interrupts++;
+        } else {
+            imu->stats.timeouts++;
+        }
+        if (imu->stop) {
+            break;
+        }
+
+        xSemaphoreTake(imu->lock, portMAX_DELAY);
+        size_t count = neo_imu_read(imu);
+        xSemaphoreGive(imu->lock);
+        if (count == 0) {
+            continue;
+        }
+        imu->stats.samples += count;
+
+        if (imu->config.sink != NULL) {
+            imu->config.sink(imu->samples, count, imu->config.sink_arg);
+        }
+        if (imu->config.loop != NULL) {
+            esp_event_post_to(imu->config.loop, NEO_IMU_EVENTS, NEO_IMU_DATA_READY,
+                              &imu->samples[count - 1], sizeof(icm42670_sample_t), 0);
+        }
+    }
+
+    xSemaphoreGive(imu->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t neo_imu_start(neo_imu_handle_t imu)
+{
+    if (imu->task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    imu->stop = false;
+    if (xTaskCreate(neo_imu_task, "neo_imu", 4096, imu, CONFIG_NEO_IMU_TASK_PRIORITY, &imu->task) != pdPASS) {
+        imu->task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    // INT1 may already be latched high; a first read clears it so the next edge is seen
+    xTaskNotifyGive(imu->task);
+    gpio_intr_enable(imu->config.int_gpio);
+
+    ESP_LOGI(TAG, "Reader started on GPIO %d (%s)", imu->config.int_gpio,
+             imu->config.watermark > 0 ? "FIFO watermark" : "data ready");
+    return ESP_OK;
+}
+
+esp_err_t neo_imu_wom_start(neo_imu_handle_t imu, const icm42670_wom_cfg_t *config)
+{
+    // Under the lock no read is in flight; the flag keeps the task from reading in low-power mode
+    xSemaphoreTake(imu->lock, portMAX_DELAY);
+    if (imu->wom) {
+        xSemaphoreGive(imu->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    imu->wom = true;
+
+    esp_err_t ret = neo_imu_int_route(imu, false);
+    if (ret == ESP_OK) {
+        ret = icm42670_wom_enable(imu->config.imu, config);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Wake on Motion failed: %s", esp_err_to_name(ret));
+        icm42670_wom_disable(imu->config.imu);
+        neo_imu_int_route(imu, true);
+        imu->wom = false;
+        xSemaphoreGive(imu->lock);
+        return ret;
+    }
+    xSemaphoreGive(imu->lock);
+
+    ESP_LOGI(TAG, "Waiting for motion");
+    return ESP_OK;
+}
+
+esp_err_t neo_imu_wom_stop(neo_imu_handle_t imu)
+{
+    xSemaphoreTake(imu->lock, portMAX_DELAY);
+    if (!imu->wom) {
+        xSemaphoreGive(imu->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = icm42670_wom_disable(imu->config.imu);
+    if (ret != ESP_OK) {
+        xSemaphoreGive(imu->lock);
+        return ret;
+    }
+
+    // Whatever the FIFO caught in low-power mode is not part of the stream
+    if (imu->config.watermark > 0) {
+        icm42670_fifo_flush(imu->config.imu);
+    }
+    ret = neo_imu_int_route(imu, true);
+
+    imu->wom = false;
+    xSemaphoreGive(imu->lock);
+    return ret;
+}
+
+esp_err_t neo_imu_reconfigure(neo_imu_handle_t imu, const icm42670_cfg_t *config, bool flush)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(imu->lock, portMAX_DELAY);
+    esp_err_t ret = icm42670_reconfigure(imu->config.imu, config, flush);
+    xSemaphoreGive(imu->lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Reconfigure failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+void neo_imu_get_stats(neo_imu_handle_t imu, neo_imu_stats_t *stats)
+{
+    *stats = imu->stats;
+}
+
+void neo_imu_delete(neo_imu_handle_t imu)
+{
+    gpio_intr_disable(imu->config.int_gpio);
+    gpio_isr_handler_remove(imu->config.int_gpio);
+
+    if (imu->task != NULL) {
+        imu->stop = true;
+        xTaskNotifyGive(imu->task);
+        xSemaphoreTake(imu->done, portMAX_DELAY);
+        imu->task = NULL;
+    }
+
+    if (imu->wom) {
+        icm42670_wom_disable(imu->config.imu);
+    }
+    neo_imu_int_route(imu, false);
+
+    vSemaphoreDelete(imu->done);
+    vSemaphoreDelete(imu->lock);
+    free(imu);
+}
@@ -0,0 +1,204 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "neo_imu_features.h"
+
+#define WINDOW  CONFIG_NEO_IMU_FEAT_WINDOW
+#define BANDS   CONFIG_NEO_IMU_FEAT_BANDS
+
+_Static_assert((WINDOW & (WINDOW - 1)) == 0, "CONFIG_NEO_IMU_FEAT_WINDOW must be a power of two");
+_Static_assert((BANDS & (BANDS - 1)) == 0, "CONFIG_NEO_IMU_FEAT_BANDS must be a power of two");
+// Band 0 loses the DC bin, so it needs a second one to be non-empty
+_Static_assert(BANDS <= WINDOW / 4, "CONFIG_NEO_IMU_FEAT_BANDS must be at most a quarter of the window");
+
+struct neo_imu_features {
+    neo_imu_features_sink_t sink;
+    void *sink_arg;
+    float band_hz;
+    float energy_scale;             // turns |X|^2 into signal power
+    size_t count;
+    int64_t first_us;
+    int64_t last_us;
+    float data[NEO_IMU_FEAT_AXES][WINDOW];
+    float re[WINDOW];
+    float im[WINDOW];
+    float hann[WINDOW];
+    float cos_t[WINDOW / 2];
+    float sin_t[WINDOW / 2];
+    neo_imu_features_t record;
+};
+
+esp_err_t neo_imu_features_create(float sample_rate_hz, neo_imu_features_sink_t sink, void *sink_arg,
+                                  neo_imu_features_handle_t *handle_ret)
+{
+    if (sink == NULL || sample_rate_hz <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct neo_imu_features *feat = calloc(1, sizeof(struct neo_imu_features));
+    if (feat == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    feat->sink = sink;
+    feat->sink_arg = sink_arg;
+    feat->band_hz = (WINDOW / 2 / BANDS) * sample_rate_hz / WINDOW;
+
+    // Tables once here, so a window costs no trigonometry
+    float hann_power = 0;
+    for (size_t i = 0; i < WINDOW; i++) {
+        feat->hann[i] = 0.5f - 0.5f * cosf(2 * (float) M_PI * i / WINDOW);
+        hann_power += feat->hann[i] * feat->hann[i];
+    }
+    for (size_t i = 0; i < WINDOW / 2; i++) {
+        feat->cos_t[i] = cosf(2 * (float) M_PI * i / WINDOW);
+        feat->sin_t[i] = sinf(2 * (float) M_PI * i / WINDOW);
+    }
+    // One-sided spectrum: every bin but DC stands for its negative twin too
+    feat->energy_scale = 2.0f / (WINDOW * hann_power);
+
+    *handle_ret = feat;
+    return ESP_OK;
+}
+
+static void fft_radix2(struct neo_imu_features *feat)
+{
+    float *re = feat->re;
+    float *im = feat->im;
+
+    for (size_t i = 1, j = 0; i < WINDOW; i++) {
+        size_t bit = WINDOW >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+
+    for (size_t len = 2; len <= WINDOW; len <<= 1) {
+        size_t half = len / 2;
+        size_t step = WINDOW / len;
+        for (size_t i = 0; i < WINDOW; i += len) {
+            for (size_t k = 0; k < half; k++) {
+                float wr = feat->cos_t[k * step];
+                float wi = -feat->sin_t[k * step];
+                size_t a = i + k;
+                size_t b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+static void axis_features(const float *x, neo_imu_axis_features_t *out)
+{
+    float sum = 0;
+    for (size_t i = 0; i < WINDOW; i++) {
+        sum += x[i];
+    }
+    float mean = sum / WINDOW;
+
+    float sq = 0;
+    float peak = 0;
+    uint16_t crossings = 0;
+    bool prev_neg = x[0] < mean;
+    for (size_t i = 0; i < WINDOW; i++) {
+        float d = x[i] - mean;
+        sq += d * d;
+        if (fabsf(d) > peak) {
+            peak = fabsf(d);
+        }
+        bool neg = d < 0;
+        if (neg != prev_neg) {
+            crossings++;
+        }
+        prev_neg = neg;
+    }
+
+    out->mean = mean;
+    out->rms = sqrtf(sq / WINDOW);
+    out->peak = peak;
+    out->zero_crossings = crossings;
+}
+
+static void band_energy(struct neo_imu_features *feat, const float *x, float mean, float *bands)
+{
+    for (size_t i = 0; i < WINDOW; i++) {
+        feat->re[i] = (x[i] - mean) * feat->hann[i];
+        feat->im[i] = 0;
+    }
+
+    fft_radix2(feat);
+
+    // Bins 1 to N/2 - 1 split evenly; DC is the mean, already reported
+    const size_t bins = (WINDOW / 2) / BANDS;
+    for (size_t b = 0; b < BANDS; b++) {
+        float e = 0;
+        size_t first = b * bins > 0 ? b * bins : 1;
+        for (size_t k = first; k < (b + 1) * bins; k++) {
+            e += feat->re[k] * feat->re[k] + feat->im[k] * feat->im[k];
+        }
+        bands[b] = e * feat->energy_scale;
+    }
+}
+
+static void neo_imu_features_emit(struct neo_imu_features *feat)
+{
+    neo_imu_features_t *r = &feat->record;
+
+    r->timestamp_us = feat->first_us;
+    r->duration_us = feat->last_us - feat->first_us;
+    r->band_hz = feat->band_hz;
+
+    for (size_t a = 0; a < NEO_IMU_FEAT_AXES; a++) {
+        axis_features(feat->data[a], &r->axis[a]);
+    }
+    for (size_t a = 0; a < NEO_IMU_FEAT_FFT; a++) {
+        band_energy(feat, feat->data[a], r->axis[a].mean, r->band_energy[a]);
+    }
+
+    feat->sink(r, feat->sink_arg);
+}
+
+void neo_imu_features_add(neo_imu_features_handle_t feat, const icm42670_sample_t *samples, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        const icm42670_sample_t *s = &samples[i];
+        size_t n = feat->count;
+
+        if (n == 0) {
+            feat->first_us = s->timestamp_us;
+        }
+        feat->last_us = s->timestamp_us;
+
+        feat->data[0][n] = s->acce.x;
+        feat->data[1][n] = s->acce.y;
+        feat->data[2][n] = s->acce.z;
+        feat->data[3][n] = s->gyro.x;
+        feat->data[4][n] = s->gyro.y;
+        feat->data[5][n] = s->gyro.z;
+
+        if (++feat->count == WINDOW) {
+            neo_imu_features_emit(feat);
+            feat->count = 0;
+        }
+    }
+}
+
+void neo_imu_features_delete(neo_imu_features_handle_t feat)
+{
+    free(feat);
+}
@@ -1,6 +1,23 @@
-#include "driver/i2c_master.h"
+#pragma once
+
+#include "neo_i2c.h"
+#include "neo_sensor.h"
+
+#define SI7021_CONVERSION_US  25000  // RH 12 bit (12 ms) + temperatura 14 bit (10.8 ms)
+
+typedef struct {
+    neo_i2c_dev_handle_t i2c_handle;
+    uint32_t bus_errors;    // transmit/receive que no devolvieron ESP_OK (NACK, timeout)
+    uint32_t crc_errors;    // tramas recibidas con CRC incorrecto
+    uint32_t retries;       // reintentos realizados
+    uint32_t failures;      // lecturas descartadas tras agotar los reintentos
+} si7021_t;
 
 uint8_t si7021_crc(const uint8_t *data, int len);
-float si7021_read_temperature(i2c_master_dev_handle_t dev);
-float si7021_read_humidity(i2c_master_dev_handle_t dev);
-i2c_master_dev_handle_t  si7021_init(i2c_master_bus_handle_t bus_handle);
\ No newline at end of file
+esp_err_t si7021_read_temperature(si7021_t *dev, float *temp);
+esp_err_t si7021_read_humidity(si7021_t *dev, float *hum);
+esp_err_t si7021_start_measurement(si7021_t *dev);
+esp_err_t si7021_fetch_measurement(si7021_t *dev, float *temp, float *hum);
+esp_err_t si7021_init(i2c_master_bus_handle_t bus_handle, si7021_t *dev);
+void si7021_deinit(si7021_t *dev);
+void si7021_sensor_bind(si7021_t *dev, uint8_t id, neo_sensor_t *sensor);
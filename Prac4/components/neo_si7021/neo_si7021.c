@@ -4,8 +4,16 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "sdkconfig.h"
+
 #define I2C_FREQ_HZ      100000
 #define I2C_DEV_ADDR     0x40    // Dirección I2C del Si7021
+#define I2C_TIMEOUT_MS   50
+
+#define CMD_MEASURE_TEMP 0xE3    // hold master
+#define CMD_MEASURE_RH   0xE5    // hold master
+#define CMD_MEASURE_RH_NOHOLD 0xF5
+#define CMD_READ_PREV_TEMP    0xE0  // temperatura medida durante la ultima medida de RH
 
 static const char *TAG = "si7021";
 
@@ -24,64 +32,137 @@ uint8_t si7021_crc(const uint8_t *data, int len)
     return crc;
 }
 
-float si7021_read_temperature(i2c_master_dev_handle_t dev)
+/*
+ * Lanza una medida y lee los 2 bytes + CRC. Un NACK, un timeout o un CRC
+ * incorrecto cuentan como intento fallido; tras CONFIG_NEO_SI7021_MAX_RETRIES
+ * reintentos se devuelve el ultimo error y *raw no se modifica.
+ */
+static esp_err_t si7021_read_raw(si7021_t *dev, uint8_t cmd, uint16_t *raw)
 {
+    esp_err_t ret = ESP_FAIL;
     uint8_t data[3];
-    uint8_t cmd = 0xE3;  //hold master
-//    esp_err_t ret = i2c_master_transmit_receive(dev, &cmd, 1, data, 3, -1);
-    esp_err_t ret = i2c_master_transmit(dev, &cmd, 1, -1);
-    vTaskDelay(pdMS_TO_TICKS(100));  // Esperar 100ms
-    ret = i2c_master_receive(dev, data, 3, -1);
 
-    uint16_t raw = (data[0] << 8) | data[1];
+    for (int attempt = 0; attempt <= CONFIG_NEO_SI7021_MAX_RETRIES; attempt++) {
+        if (attempt > 0) {
+            dev->retries++;
+        }
 
-    uint8_t crc_loc = si7021_crc(data, 2);
-    if (crc_loc != data[2]) {
-        ESP_LOGE(TAG, "CRC mismatch! crc should be 0x%02X received 0x%02X", crc_loc, data[2]);
+        ret = neo_i2c_transmit(dev->i2c_handle, &cmd, 1, I2C_TIMEOUT_MS);
+        if (ret == ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(100));  // Esperar 100ms
+            ret = neo_i2c_receive(dev->i2c_handle, data, 3, I2C_TIMEOUT_MS);
+        }
+        if (ret != ESP_OK) {
+            dev->bus_errors++;
+            ESP_LOGD(TAG, "cmd 0x%02X attempt %d: %s", cmd, attempt, esp_err_to_name(ret));
+            continue;
+        }
+
+        uint8_t crc_loc = si7021_crc(data, 2);
+        if (crc_loc != data[2]) {
+            dev->crc_errors++;
+            ret = ESP_ERR_INVALID_CRC;
+            ESP_LOGD(TAG, "CRC mismatch! crc should be 0x%02X received 0x%02X", crc_loc, data[2]);
+            continue;
+        }
+
+        *raw = (data[0] << 8) | data[1];
+        return ESP_OK;
     }
-    else{
-        ESP_LOGE(TAG, "CRC match");
+
+    dev->failures++;
+    ESP_LOGW(TAG, "cmd 0x%02X dropped after %d attempts: %s",
+             cmd, CONFIG_NEO_SI7021_MAX_RETRIES + 1, esp_err_to_name(ret));
+    return ret;
+}
+
+esp_err_t si7021_read_temperature(si7021_t *dev, float *temp)
+{
+    uint16_t raw;
+
+    esp_err_t ret = si7021_read_raw(dev, CMD_MEASURE_TEMP, &raw);
+    if (ret != ESP_OK) {
+        return ret;
     }
 
-    float temp_c = ((175.72f * raw) / 65536.0f) - 46.85f;
-    return temp_c;
+    *temp = ((175.72f * raw) / 65536.0f) - 46.85f;
+    return ESP_OK;
 }
 
-float si7021_read_humidity(i2c_master_dev_handle_t dev)
+esp_err_t si7021_read_humidity(si7021_t *dev, float *hum)
+{
+    uint16_t raw;
+
+    esp_err_t ret = si7021_read_raw(dev, CMD_MEASURE_RH, &raw);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    float rh = ((125.0f * raw) / 65536.0f) - 6.0f;
+    if (rh > 100.0f) rh = 100.0f;
+    if (rh < 0.0f) rh = 0.0f;
+    *hum = rh;
+    return ESP_OK;
+}
+
+esp_err_t si7021_start_measurement(si7021_t *dev)
+{
+    uint8_t cmd = CMD_MEASURE_RH_NOHOLD;
+
+    esp_err_t ret = neo_i2c_transmit(dev->i2c_handle, &cmd, 1, I2C_TIMEOUT_MS);
+    if (ret != ESP_OK) {
+        dev->bus_errors++;
+    }
+    return ret;
+}
+
+esp_err_t si7021_fetch_measurement(si7021_t *dev, float *temp, float *hum)
 {
     uint8_t data[3];
-    uint8_t cmd = 0xE5;  //hold master
- //   esp_err_t ret = i2c_master_transmit_receive(dev, &cmd, 1, data, 3, -1);
-    esp_err_t ret = i2c_master_transmit(dev, &cmd, 1, -1);
-    vTaskDelay(pdMS_TO_TICKS(100));  // Esperar 100ms
-    ret = i2c_master_receive(dev, data, 3, -1);
-    uint16_t raw = (data[0] << 8) | data[1];
+    uint8_t cmd = CMD_READ_PREV_TEMP;
+
+    esp_err_t ret = neo_i2c_receive(dev->i2c_handle, data, 3, I2C_TIMEOUT_MS);
+    if (ret != ESP_OK) {
+        dev->bus_errors++;
+        return ret;
+    }
 
     uint8_t crc_loc = si7021_crc(data, 2);
     if (crc_loc != data[2]) {
-        ESP_LOGE(TAG, "CRC mismatch! crc should be 0x%02X received 0x%02X", crc_loc, data[2]);
+        dev->crc_errors++;
+        ESP_LOGD(TAG, "CRC mismatch! crc should be 0x%02X received 0x%02X", crc_loc, data[2]);
+        return ESP_ERR_INVALID_CRC;
     }
-    else{
-        ESP_LOGE(TAG, "CRC match");
+    uint16_t raw_rh = (data[0] << 8) | data[1];
+
+    // 0xE0 no lleva CRC
+    ret = neo_i2c_transmit_receive(dev->i2c_handle, &cmd, 1, data, 2, I2C_TIMEOUT_MS);
+    if (ret != ESP_OK) {
+        dev->bus_errors++;
+        return ret;
     }
+    uint16_t raw_t = (data[0] << 8) | data[1];
 
-    float rh = ((125.0f * raw) / 65536.0f) - 6.0f;
+    float rh = ((125.0f * raw_rh) / 65536.0f) - 6.0f;
     if (rh > 100.0f) rh = 100.0f;
     if (rh < 0.0f) rh = 0.0f;
-    return rh;
+
+    *hum = rh;
+    *temp = ((175.72f * raw_t) / 65536.0f) - 46.85f;
+    return ESP_OK;
 }
 
-i2c_master_dev_handle_t  si7021_init(i2c_master_bus_handle_t bus_handle)
+esp_err_t si7021_init(i2c_master_bus_handle_t bus_handle, si7021_t *dev)
 {
-    i2c_device_config_t dev_config = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = I2C_DEV_ADDR,
-        .scl_speed_hz = I2C_FREQ_HZ,
-    };
-
-    i2c_master_dev_handle_t si7021;
+    *dev = (si7021_t) {0};
 
-    ESP_ERROR_CHECK(i2c_master_bus_add_device(bus_handle, &dev_config, &si7021));
+    return neo_i2c_add_device(bus_handle, "si7021", I2C_DEV_ADDR, I2C_FREQ_HZ, &dev->i2c_handle);
+}
 
-    return si7021;
-}
\ No newline at end of file
+void si7021_deinit(si7021_t *dev)
+{
+    if (dev->i2c_handle) {
+        neo_i2c_remove_device(dev->i2c_handle);
+        dev->i2c_handle = NULL;
+    }
+}
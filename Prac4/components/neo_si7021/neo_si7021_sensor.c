@@ -0,0 +1,42 @@
+#include "neo_si7021.h"
+
+static esp_err_t si7021_sensor_start(neo_sensor_t *sensor)
+{
+    return si7021_start_measurement((si7021_t *) sensor->ctx);
+}
+
+static esp_err_t si7021_sensor_fetch(neo_sensor_t *sensor, neo_sample_t *samples, size_t max_samples, size_t *count)
+{
+    float temp, hum;
+
+    if (max_samples < 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = si7021_fetch_measurement((si7021_t *) sensor->ctx, &temp, &hum);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    samples[0] = (neo_sample_t) { .kind = NEO_SAMPLE_TEMPERATURE, .value = { temp } };
+    samples[1] = (neo_sample_t) { .kind = NEO_SAMPLE_HUMIDITY, .value = { hum } };
+    *count = 2;
+
+    return ESP_OK;
+}
+
+static const neo_sensor_ops_t si7021_sensor_ops = {
+    .start = si7021_sensor_start,
+    .fetch = si7021_sensor_fetch,
+};
+
+void si7021_sensor_bind(si7021_t *dev, uint8_t id, neo_sensor_t *sensor)
+{
+    *sensor = (neo_sensor_t) {
+        .ops = &si7021_sensor_ops,
+        .name = "si7021",
+        .ctx = dev,
+        .conversion_us = SI7021_CONVERSION_US,
+        .id = id,
+    };
+}
@@ -2,6 +2,7 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 
 #include "unity.h"  //for unit equalaity test
 
@@ -9,8 +10,12 @@
 
 #include "neo_i2c.h"
 #include "neo_si7021.h"
+#include "neo_sensor_sched.h"
 
 #include "icm42670.h"
+#include "icm42670_filter.h"
+#include "neo_imu.h"
+#include "neo_imu_features.h"
 
 #include "blink.h"
 
@@ -18,6 +23,18 @@ static const char *TAG = "Prac4";
 
 static icm42670_handle_t icm42670 = NULL;
 
+/* 400 Hz con interrupcion cada 20 muestras: un lote cada 50 ms */
+#define IMU_WATERMARK       20
+#define IMU_LOG_EVERY       10
+#define IMU_DT              (1.0f / 400)
+#define IMU_RUN_MS          50000
+#define IMU_WOM_WAIT_MS     60000
+#define IMU_WOM_THR_MG      50
+
+static SemaphoreHandle_t imu_motion;
+static icm42670_cf_t imu_attitude;
+static neo_imu_features_handle_t imu_features;
+
 int map_gyro_to_rgb(float value)
 {
     int rgb = (int)((value + 180.0f) / 360.0f * 255.0f);
@@ -28,6 +45,69 @@ int map_gyro_to_rgb(float value)
     return rgb;
 }
 
+static void log_samples(const neo_sample_t *samples, size_t count, void *arg)
+{
+    for (size_t i = 0; i < count; i++) {
+        switch (samples[i].kind) {
+            case NEO_SAMPLE_TEMPERATURE:
+                ESP_LOGI(TAG, " Temperatura: %.2f °C", samples[i].value[0]);
+                break;
+            case NEO_SAMPLE_HUMIDITY:
+                ESP_LOGI(TAG, " Humedad: %.2f %%", samples[i].value[0]);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void imu_samples_ready(const icm42670_sample_t *samples, size_t count, void *arg)
+{
+    static uint32_t batches;
+    const icm42670_sample_t *last = &samples[count - 1];
+
+    icm42670_cf_update(&imu_attitude, samples, count, IMU_DT);
+    neo_imu_features_add(imu_features, samples, count);
+
+    if (++batches % IMU_LOG_EVERY == 0) {
+        ESP_LOGI(TAG, "%u muestras, acc_x:%.2f, acc_y:%.2f, acc_z:%.2f, gyro_x:%.2f, gyro_y:%.2f, gyro_z:%.2f temp: %.1f roll: %.1f pitch: %.1f",
+                (unsigned) count, last->acce.x, last->acce.y, last->acce.z,
+                last->gyro.x, last->gyro.y, last->gyro.z, last->temp,
+                imu_attitude.angle.roll, imu_attitude.angle.pitch);
+    }
+
+    blink_set(map_gyro_to_rgb(last->gyro.x), map_gyro_to_rgb(last->gyro.y), map_gyro_to_rgb(last->gyro.z), 1);
+}
+
+/* Un registro por ventana en lugar de las muestras en crudo */
+static void imu_features_ready(const neo_imu_features_t *features, void *arg)
+{
+    for (int a = 0; a < NEO_IMU_FEAT_FFT; a++) {
+        const neo_imu_axis_features_t *f = &features->axis[a];
+        int top = 0;
+        for (int b = 1; b < CONFIG_NEO_IMU_FEAT_BANDS; b++) {
+            if (features->band_energy[a][b] > features->band_energy[a][top]) {
+                top = b;
+            }
+        }
+        ESP_LOGI(TAG, "acc %c: media %.3f rms %.3f pico %.3f cruces %u banda %.0f-%.0f Hz",
+                "xyz"[a], f->mean, f->rms, f->peak, f->zero_crossings,
+                top * features->band_hz, (top + 1) * features->band_hz);
+    }
+}
+
+static void imu_event(void* handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    switch (event_id) {
+        case NEO_IMU_MOTION:
+            ESP_LOGI(TAG, "Movimiento detectado (0x%02x)", *(uint8_t *) event_data);
+            xSemaphoreGive(imu_motion);
+            break;
+        default:
+            break;
+    }
+}
+
 static void i2c_sensor_icm42670_init(i2c_master_bus_handle_t bus_handle)
 {
     esp_err_t ret;
@@ -65,25 +145,34 @@ void app_main(void)
             i2c_master_bus_handle_t bus_handle_esp32 = i2c_init(GP_SCL, GP_SDA);
 
             // Añadir el dispositivo Si7021
-            i2c_master_dev_handle_t si7021 = si7021_init(bus_handle_esp32);
+            si7021_t si7021;
+            ESP_ERROR_CHECK(si7021_init(bus_handle_esp32, &si7021));
+
+            neo_sensor_t si7021_sensor;
+            si7021_sensor_bind(&si7021, 0, &si7021_sensor);
+
+            // Una sola tarea muestrea todos los sensores del bus
+            neo_sched_handle_t sched;
+            const neo_sched_config_t sched_cfg = {
+                .sink = log_samples,
+                .jitter_ms = 10,
+            };
+            ESP_ERROR_CHECK(neo_sched_create(&sched_cfg, &sched));
+            ESP_ERROR_CHECK(neo_sched_add(sched, &si7021_sensor, 2000));
+            ESP_ERROR_CHECK(neo_sched_start(sched));
 
-            // Bucle principal: alternar lecturas cada segundo
             while (1) {
-                float temp = si7021_read_temperature(si7021);
-                if (temp > -100.0f)
-                    ESP_LOGI(TAG, " Temperatura: %.2f °C", temp);
-                vTaskDelay(pdMS_TO_TICKS(1000));  // Esperar 1 segundo
-
-                float hum = si7021_read_humidity(si7021);
-                if (hum >= 0.0f)
-                    ESP_LOGI(TAG, " Humedad: %.2f %%", hum);
-                vTaskDelay(pdMS_TO_TICKS(1000));  // Esperar 1 segundo antes del siguiente ciclo
+                vTaskDelay(pdMS_TO_TICKS(1000));
             }
 
+            neo_sched_delete(sched);
+
             // Limpieza
-            ESP_ERROR_CHECK(i2c_master_bus_rm_device(si7021));
+            si7021_deinit(&si7021);
 
-            ESP_ERROR_CHECK(i2c_del_master_bus(bus_handle_esp32));
+            neo_i2c_log_stats(bus_handle_esp32);
+            neo_i2c_trace_log(bus_handle_esp32);
+            ESP_ERROR_CHECK(neo_i2c_bus_release(bus_handle_esp32));
             
             break;
         case CHIP_ESP32C3:
@@ -95,12 +184,10 @@ void app_main(void)
             i2c_master_bus_handle_t bus_handle_esp32c3 = i2c_init(GP_SCL, GP_SDA);
 
             esp_err_t ret;
-            icm42670_value_t acc, gyro;
-            float temperature;
-
 
             /* Configure the peripheral according to the LED type */
             led_strip_handle_t led_strip = configure_led();
+            ESP_ERROR_CHECK(blink_start(led_strip));
 
             i2c_sensor_icm42670_init(bus_handle_esp32c3);
 
@@ -110,24 +197,66 @@ void app_main(void)
             ret = icm42670_gyro_set_pwr(icm42670, GYRO_PWR_LOWNOISE);
             TEST_ASSERT_EQUAL(ESP_OK, ret);
 
-            for (int i = 0; i < 100; i++) {
-                vTaskDelay(pdMS_TO_TICKS(500));
-                ret = icm42670_get_acce_value(icm42670, &acc);
-                TEST_ASSERT_EQUAL(ESP_OK, ret);
-                ret = icm42670_get_gyro_value(icm42670, &gyro);
-                TEST_ASSERT_EQUAL(ESP_OK, ret);
-                ret = icm42670_get_temp_value(icm42670, &temperature);
-                TEST_ASSERT_EQUAL(ESP_OK, ret);
-                ESP_LOGI(TAG, "acc_x:%.2f, acc_y:%.2f, acc_z:%.2f, gyro_x:%.2f, gyro_y:%.2f, gyro_z:%.2f temp: %.1f",
-                        acc.x, acc.y, acc.z, gyro.x, gyro.y, gyro.z, temperature);
-                
-                blink_led(led_strip, map_gyro_to_rgb(gyro.x), map_gyro_to_rgb(gyro.y), map_gyro_to_rgb(gyro.z), 1);
-                
+            esp_event_loop_handle_t imu_loop;
+            const esp_event_loop_args_t loop_args = {
+                .queue_size = 5,
+                .task_name = "imu_loop",
+                .task_priority = uxTaskPriorityGet(NULL),
+                .task_stack_size = 2048,
+                .task_core_id = tskNO_AFFINITY
+            };
+            ESP_ERROR_CHECK(esp_event_loop_create(&loop_args, &imu_loop));
+            ESP_ERROR_CHECK(esp_event_handler_register_with(imu_loop, NEO_IMU_EVENTS, NEO_IMU_MOTION, imu_event, NULL));
+            imu_motion = xSemaphoreCreateBinary();
+            icm42670_cf_init(&imu_attitude, 0.99f);
+            ESP_ERROR_CHECK(neo_imu_features_create(1.0f / IMU_DT, imu_features_ready, NULL, &imu_features));
+
+            /* La FIFO avisa por INT1 al llegar al watermark y la tarea lectora la vacia de una rafaga */
+            neo_imu_handle_t imu_reader;
+            const neo_imu_config_t imu_reader_cfg = {
+                .imu = icm42670,
+                .int_gpio = CONFIG_NEO_IMU_INT_GPIO,
+                .watermark = IMU_WATERMARK,
+                .sink = imu_samples_ready,
+                .loop = imu_loop,
+            };
+            ESP_ERROR_CHECK(neo_imu_create(&imu_reader_cfg, &imu_reader));
+            ESP_ERROR_CHECK(neo_imu_start(imu_reader));
+
+            vTaskDelay(pdMS_TO_TICKS(IMU_RUN_MS));
+
+            /* En reposo solo el acelerometro en bajo consumo vigila; se vuelve a muestrear al moverse */
+            const icm42670_wom_cfg_t wom_cfg = {
+                .thr_x = ICM42670_WOM_THR_MG(IMU_WOM_THR_MG),
+                .thr_y = ICM42670_WOM_THR_MG(IMU_WOM_THR_MG),
+                .thr_z = ICM42670_WOM_THR_MG(IMU_WOM_THR_MG),
+                .odr = ACCE_ODR_50HZ,
+                .duration = 1,
+                .compare_previous = true,
+            };
+            ESP_ERROR_CHECK(neo_imu_wom_start(imu_reader, &wom_cfg));
+            if (xSemaphoreTake(imu_motion, pdMS_TO_TICKS(IMU_WOM_WAIT_MS)) == pdTRUE) {
+                ESP_ERROR_CHECK(neo_imu_wom_stop(imu_reader));
+                vTaskDelay(pdMS_TO_TICKS(IMU_RUN_MS / 10));
+            } else {
+                ESP_LOGI(TAG, "Sin movimiento");
+                ESP_ERROR_CHECK(neo_imu_wom_stop(imu_reader));
             }
 
+            neo_imu_stats_t imu_stats;
+            neo_imu_get_stats(imu_reader, &imu_stats);
+            ESP_LOGI(TAG, "IMU: %u interrupciones, %u muestras, %u timeouts, %u errores",
+                    (unsigned) imu_stats.interrupts, (unsigned) imu_stats.samples,
+                    (unsigned) imu_stats.timeouts, (unsigned) imu_stats.errors);
+            neo_imu_delete(imu_reader);
+            neo_imu_features_delete(imu_features);
+            blink_stop();
+
             icm42670_delete(icm42670);
 
-            ESP_ERROR_CHECK(i2c_del_master_bus(bus_handle_esp32c3));
+            neo_i2c_log_stats(bus_handle_esp32c3);
+            neo_i2c_trace_log(bus_handle_esp32c3);
+            ESP_ERROR_CHECK(neo_i2c_bus_release(bus_handle_esp32c3));
 
             break;
         default:
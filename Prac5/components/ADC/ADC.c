@@ -1,8 +1,68 @@
+#include <stdlib.h>
+#include <math.h>
 #include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_log.h"
+#include "ADC.h"
+
+// Full scale of ADC_ATTEN_DB_11 when the chip has no calibration in eFuse
+#define ADC_UNCALIBRATED_FULL_SCALE_MV  3100
+
+// Scans per DMA transfer: a capture waits for at most this many scans past its frame
+#define ADC_CONTINUOUS_CHUNK            8
 
 static const char *TAG = "ADC_one_shot";
 
-adc_oneshot_unit_handle_t ADC_init(){
+// Calibrated millivolts of every 12-bit code, filled once by ADC_init()
+static uint16_t raw_to_mv[4096];
+
+struct ADC_continuous {
+    adc_continuous_handle_t handle;
+    size_t frame_samples;           // per channel
+    size_t max_samples;             // frame buffer capacity per channel
+    size_t channel_count;
+    adc_digi_pattern_config_t pattern[SOC_ADC_PATT_LEN_MAX];
+    int8_t index[SOC_ADC_MAX_CHANNEL_NUM];  // channel number to row of the demultiplexed frame, -1 if not scanned
+    uint32_t frame_bytes;
+    uint8_t *frame;
+};
+
+static void ADC_calibration_init(){
+    adc_cali_handle_t cali_handle = NULL;
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_config = {
+        .unit_id = ADC_UNIT_1,
+        .atten = ADC_ATTEN_DB_11,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    ret = adc_cali_create_scheme_line_fitting(&cali_config, &cali_handle);
+#endif
+
+    // One pass over the codes here, no calibration call per sample afterwards
+    for (int raw = 0; raw < 4096; raw++){
+        int mv = raw * ADC_UNCALIBRATED_FULL_SCALE_MV / 4095;
+        if (ret == ESP_OK){
+            adc_cali_raw_to_voltage(cali_handle, raw, &mv);
+        }
+        raw_to_mv[raw] = mv;
+    }
+
+    if (ret == ESP_OK){
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_line_fitting(cali_handle);
+#endif
+        ESP_LOGI(TAG, "Calibrated, full scale %d mV", raw_to_mv[4095]);
+    }
+    else{
+        ESP_LOGW(TAG, "No calibration (%s), assuming %d mV full scale", esp_err_to_name(ret), ADC_UNCALIBRATED_FULL_SCALE_MV);
+    }
+}
+
+adc_oneshot_unit_handle_t ADC_init(adc_channel_t channel){
     adc_oneshot_unit_handle_t adc1_handle;
     adc_oneshot_unit_init_cfg_t init_config1 = {
         .unit_id = ADC_UNIT_1,
@@ -15,16 +75,198 @@ adc_oneshot_unit_handle_t ADC_init(){
         .atten = ADC_ATTEN_DB_11,
     };
 
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, ADC_CHANNEL_6, &config));
+    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, channel, &config));
+
+    ADC_calibration_init();
 
     return adc1_handle;
 }
 
-float read_voltage(adc_oneshot_unit_handle_t adc_handle){
+int ADC_raw_to_mv(int adc_raw){
+    // Clamped, a code past either end reads as that end rather than wrapping around
+    if (adc_raw < 0){
+        adc_raw = 0;
+    }
+    else if (adc_raw > 4095){
+        adc_raw = 4095;
+    }
+    return raw_to_mv[adc_raw];
+}
+
+float ADC_raw_to_voltage(int adc_raw){
+    return ADC_raw_to_mv(adc_raw) / 1000.0f;
+}
+
+esp_err_t ADC_read_raw(adc_oneshot_unit_handle_t adc_handle, adc_channel_t channel, int *raw){
+    // Not ESP_ERROR_CHECK: the unit is busy, not broken, while a continuous capture runs
+    return adc_oneshot_read(adc_handle, channel, raw);
+}
+
+float read_voltage(adc_oneshot_unit_handle_t adc_handle, adc_channel_t channel){
     int adc_raw;
-    ESP_ERROR_CHECK(adc_oneshot_read(adc_handle, ADC_CHANNEL_6, &adc_raw));
-    
-    float voltage = (float) adc_raw / 4095.0f * 5.0f;
+    if (ADC_read_raw(adc_handle, channel, &adc_raw) != ESP_OK){
+        return NAN;
+    }
+
+    float voltage = ADC_raw_to_voltage(adc_raw);
 
     return voltage;
+}
+
+// The DMA moves whole conversions, so a frame is rounded up to one
+static uint32_t ADC_continuous_bytes(const struct ADC_continuous *adc, size_t samples){
+    uint32_t bytes = samples * adc->channel_count * SOC_ADC_DIGI_RESULT_BYTES;
+    return (bytes + SOC_ADC_DIGI_DATA_BYTES_PER_CONV - 1) / SOC_ADC_DIGI_DATA_BYTES_PER_CONV * SOC_ADC_DIGI_DATA_BYTES_PER_CONV;
+}
+
+// Creates the driver once, sized for max_samples per channel: the DMA hands over chunks of
+// ADC_CONTINUOUS_CHUNK scans and a shorter frame just reads fewer of them
+static esp_err_t ADC_continuous_open(struct ADC_continuous *adc){
+
+    // The ISR drops a chunk the store cannot take whole, so it holds two of whichever is larger
+    uint32_t frame_bytes = ADC_continuous_bytes(adc, adc->max_samples);
+    uint32_t chunk_bytes = ADC_continuous_bytes(adc, ADC_CONTINUOUS_CHUNK);
+
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = (frame_bytes > chunk_bytes ? frame_bytes : chunk_bytes) * 2,
+        .conv_frame_size = chunk_bytes,
+    };
+    esp_err_t ret = adc_continuous_new_handle(&handle_config, &adc->handle);
+    if (ret != ESP_OK){
+        adc->handle = NULL;
+        return ret;
+    }
+
+    adc_continuous_config_t config = {
+        .pattern_num = adc->channel_count,
+        .adc_pattern = adc->pattern,
+        .sample_freq_hz = CONFIG_NEO_ADC_SAMPLE_FREQ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    ret = adc_continuous_config(adc->handle, &config);
+    if (ret != ESP_OK){
+        adc_continuous_deinit(adc->handle);
+        adc->handle = NULL;
+        return ret;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ADC_continuous_init(const adc_channel_t *channels, size_t channel_count, size_t frame_samples, ADC_continuous_handle_t *handle_ret){
+
+    if (frame_samples == 0 || channel_count == 0 || channel_count > SOC_ADC_PATT_LEN_MAX){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct ADC_continuous *adc = calloc(1, sizeof(struct ADC_continuous));
+    if (adc == NULL){
+        return ESP_ERR_NO_MEM;
+    }
+
+    // One pattern entry per channel, the scan converts them in turn
+    for (size_t i = 0; i < SOC_ADC_MAX_CHANNEL_NUM; i++){
+        adc->index[i] = -1;
+    }
+    for (size_t i = 0; i < channel_count; i++){
+        if (channels[i] >= SOC_ADC_MAX_CHANNEL_NUM || adc->index[channels[i]] >= 0){
+            free(adc);
+            return ESP_ERR_INVALID_ARG;
+        }
+        adc->index[channels[i]] = i;
+        adc->pattern[i] = (adc_digi_pattern_config_t) {
+            .atten = ADC_ATTEN_DB_11,
+            .channel = channels[i],
+            .unit = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+    }
+    adc->channel_count = channel_count;
+
+    // Sized for the largest frame, ADC_continuous_set_frame() only goes down from here
+    adc->max_samples = frame_samples;
+    adc->frame = malloc(frame_samples * channel_count * SOC_ADC_DIGI_RESULT_BYTES + SOC_ADC_DIGI_DATA_BYTES_PER_CONV);
+    if (adc->frame == NULL){
+        free(adc);
+        return ESP_ERR_NO_MEM;
+    }
+
+    adc->frame_samples = frame_samples;
+    adc->frame_bytes = ADC_continuous_bytes(adc, frame_samples);
+
+    esp_err_t ret = ADC_continuous_open(adc);
+    if (ret != ESP_OK){
+        ADC_continuous_deinit(adc);
+        return ret;
+    }
+
+    *handle_ret = adc;
+    return ESP_OK;
+}
+
+esp_err_t ADC_continuous_set_frame(ADC_continuous_handle_t adc, size_t frame_samples){
+
+    if (frame_samples == 0 || frame_samples > adc->max_samples){
+        return ESP_ERR_INVALID_ARG;
+    }
+    // No driver change, the next capture just stops reading earlier or later
+    adc->frame_samples = frame_samples;
+    adc->frame_bytes = ADC_continuous_bytes(adc, frame_samples);
+
+    return ESP_OK;
+}
+
+esp_err_t ADC_continuous_capture(ADC_continuous_handle_t adc, uint16_t *raw, size_t *counts){
+
+    uint32_t got = 0;
+    uint32_t len = 0;
+
+    for (size_t c = 0; c < adc->channel_count; c++){
+        counts[c] = 0;
+    }
+
+    esp_err_t ret = adc_continuous_start(adc->handle);
+    if (ret != ESP_OK){
+        return ret;
+    }
+
+    // The read sleeps on the driver until the DMA has pushed a chunk, the frame takes as many as it needs
+    while (got < adc->frame_bytes){
+        ret = adc_continuous_read(adc->handle, adc->frame + got, adc->frame_bytes - got, &len, 100);
+        if (ret != ESP_OK){
+            break;
+        }
+        got += len;
+    }
+
+    adc_continuous_stop(adc->handle);
+
+    // Demultiplex: each channel gets its own row of frame_samples codes
+    for (uint32_t i = 0; ret == ESP_OK && i < got; i += SOC_ADC_DIGI_RESULT_BYTES){
+        adc_digi_output_data_t *p = (adc_digi_output_data_t *) &adc->frame[i];
+        int row = p->type1.channel < SOC_ADC_MAX_CHANNEL_NUM ? adc->index[p->type1.channel] : -1;
+        if (row >= 0 && counts[row] < adc->frame_samples){
+            raw[row * adc->frame_samples + counts[row]++] = p->type1.data;
+        }
+    }
+
+    // Frames converted after ours would be read first by the next capture
+    while (adc_continuous_read(adc->handle, adc->frame, adc->frame_bytes, &len, 0) == ESP_OK){
+    }
+
+    if (ret != ESP_OK){
+        ESP_LOGW(TAG, "Frame capture failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    return ESP_OK;
+}
+
+void ADC_continuous_deinit(ADC_continuous_handle_t adc){
+    if (adc->handle != NULL){
+        adc_continuous_deinit(adc->handle);
+    }
+    free(adc->frame);
+    free(adc);
 }
\ No newline at end of file
@@ -1,5 +1,35 @@
+#pragma once
+
+#include <stddef.h>
 #include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
+
+// Oneshot unit on ADC1 with channel configured for the reads below
+adc_oneshot_unit_handle_t ADC_init(adc_channel_t channel);
+
+// ESP_ERR_TIMEOUT while a continuous capture holds ADC1
+esp_err_t ADC_read_raw(adc_oneshot_unit_handle_t adc_handle, adc_channel_t channel, int *raw);
+
+// NAN when the read fails
+float read_voltage(adc_oneshot_unit_handle_t adc_handle, adc_channel_t channel);
+
+// Both use the calibration table built by ADC_init(), codes outside 0..4095 are clamped
+int ADC_raw_to_mv(int adc_raw);
+
+float ADC_raw_to_voltage(int adc_raw);
+
+// Continuous (DMA) captures: one frame of samples per call instead of one driver call per sample
+typedef struct ADC_continuous *ADC_continuous_handle_t;
+
+// Scans the channels of ADC1 in turn, frame_samples of each per capture
+esp_err_t ADC_continuous_init(const adc_channel_t *channels, size_t channel_count, size_t frame_samples, ADC_continuous_handle_t *handle_ret);
+
+// Changes the samples per channel of the next captures, up to the frame_samples given to ADC_continuous_init();
+// the driver stays as it is, so this is cheap enough to call before every capture
+esp_err_t ADC_continuous_set_frame(ADC_continuous_handle_t adc, size_t frame_samples);
 
-adc_oneshot_unit_handle_t ADC_init();
+// Converts one frame at CONFIG_NEO_ADC_SAMPLE_FREQ and blocks until it is demultiplexed:
+// raw holds channel_count rows of frame_samples codes, counts[i] the codes kept in row i
+esp_err_t ADC_continuous_capture(ADC_continuous_handle_t adc, uint16_t *raw, size_t *counts);
 
-float read_voltage(adc_oneshot_unit_handle_t adc_handle);
\ No newline at end of file
+void ADC_continuous_deinit(ADC_continuous_handle_t adc);
\ No newline at end of file
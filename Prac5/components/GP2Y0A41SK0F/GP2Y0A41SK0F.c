@@ -1,4 +1,7 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "ADC.h"
 #include "GP2Y0A41SK0F.h"
 
@@ -6,7 +9,8 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
 
 #include "esp_event.h"
 
@@ -16,14 +20,73 @@ ESP_EVENT_DEFINE_BASE(PRAC5_EVENTS);
 
 static const char *TAG = "GP2Y0A41SK0F";
 
-esp_timer_handle_t adc_timer;
-
-QueueHandle_t distance_queue;
-
-TaskHandle_t adc_gp2_handle;
+// ADC1 channels of the sensors, parsed from CONFIG_GP2_CHANNELS by GP2Y0A41SK0F_init()
+static adc_channel_t gp2_channels[GP2_MAX_SENSORS];
+static size_t gp2_sensors;
+
+struct trigger_state {
+    bool reported;          // last_cm holds the distance of the last DISTANCE_CHANGED
+    float last_cm;
+    int8_t zone;            // 1 near, -1 far, 0 not known yet
+};
+
+// The chip has one continuous ADC driver, so one instance can sample at a time
+#define GP2_MAX_INSTANCES   1
+
+#define GP2_STREAM_BYTES    (CONFIG_GP2_STREAM_SAMPLES * sizeof(GP2Y0A41SK0F_sample_t))
+
+// Everything start/stop touch lives here, in a static pool: a duty cycle allocates nothing but the task
+struct GP2Y0A41SK0F {
+    bool used;
+    adc_oneshot_unit_handle_t adc_handle;
+    ADC_continuous_handle_t adc_cont;
+    esp_event_loop_handle_t loop;
+    esp_timer_handle_t timer;
+
+    // NULL while stopped; the task leaves its loop when stopping is set and gives done on its way out
+    TaskHandle_t task;
+    volatile bool stopping;
+    SemaphoreHandle_t tick;
+    SemaphoreHandle_t done;
+    StaticSemaphore_t tick_buf;
+    StaticSemaphore_t done_buf;
+
+    // Burst buffers of GP2Y0A41SK0F_measure_frame(), here rather than on the task stack for any CONFIG_GP2_MAX_N
+    uint16_t burst_raw[GP2_MAX_SENSORS * CONFIG_GP2_MAX_N];
+    uint16_t burst_codes[GP2_MAX_SENSORS][CONFIG_GP2_MAX_N];
+
+    StreamBufferHandle_t stream;
+    StaticStreamBuffer_t stream_buf;
+    uint8_t stream_storage[GP2_STREAM_BYTES + 1];
+
+    // Called by the task on every tick
+    struct {
+        GP2Y0A41SK0F_cb_t cb;
+        void *arg;
+    } subscribers[GP2_MAX_SUBSCRIBERS];
+
+    // Runtime sampling control: tick period, codes per burst and whether bursts resize themselves
+    uint32_t period_ms;
+    volatile size_t burst_n;
+    volatile bool burst_adaptive;
+
+    // Change detection, see GP2Y0A41SK0F_set_trigger()
+    GP2Y0A41SK0F_trigger_t trigger;
+    portMUX_TYPE trigger_lock;
+    struct trigger_state trigger_state[GP2_MAX_SENSORS];
+
+#if CONFIG_GP2_EMA_SHIFT > 0
+    // Exponential filter across bursts, in filtered code units shifted up by CONFIG_GP2_EMA_SHIFT
+    int32_t ema_state[GP2_MAX_SENSORS];
+#endif
+};
+
+static struct GP2Y0A41SK0F gp2_pool[GP2_MAX_INSTANCES];
 
 extern esp_event_loop_handle_t loop;
 
+static void i_read_the_god_damn_datas_and_fuking_dont_call_back(void* arg);
+
 
 /*
 static void i_read_the_god_damn_datas_and_fuking_dont_call_back(void* arg){
@@ -52,106 +115,508 @@ static void i_read_the_god_damn_datas_and_fuking_dont_call_back(void* arg){
 */
 
 
+// The semaphore outlives the task, so a tick racing GP2Y0A41SK0F_stop() is harmless
 static void timer_callback(void *arg){
 
-    xTaskNotifyGive(adc_gp2_handle);
+    struct GP2Y0A41SK0F *gp2 = (struct GP2Y0A41SK0F *) arg;
+    xSemaphoreGive(gp2->tick);
+}
+
+
+// Posts only what changed: a threshold crossed past its hysteresis or a move of at least delta_cm
+static void GP2Y0A41SK0F_post_changes(struct GP2Y0A41SK0F *gp2, const GP2Y0A41SK0F_sample_t *sample){
+
+    esp_event_loop_handle_t loop = gp2->loop;
+    GP2Y0A41SK0F_trigger_t t;
+    portENTER_CRITICAL(&gp2->trigger_lock);
+    t = gp2->trigger;
+    portEXIT_CRITICAL(&gp2->trigger_lock);
+
+    struct trigger_state *state = &gp2->trigger_state[sample->sensor];
+    float d = sample->distance;
+
+    if (!sample->quality.ok){
+        return;
+    }
+
+    if (t.near_cm > 0){
+        int8_t zone = state->zone;
+        if (d < t.near_cm){
+            zone = 1;
+        }
+        else if (d > t.near_cm + t.hysteresis_cm){
+            zone = -1;
+        }
+
+        // The first reading only sets the zone, a crossing needs a known side to start from
+        if (zone != state->zone && state->zone != 0){
+            esp_event_post_to(loop, PRAC5_EVENTS, zone > 0 ? DISTANCE_NEAR : DISTANCE_FAR, sample, sizeof(*sample), 0);
+        }
+        state->zone = zone;
+    }
+
+    if (t.delta_cm > 0){
+        if (!state->reported || fabsf(d - state->last_cm) >= t.delta_cm){
+            esp_event_post_to(loop, PRAC5_EVENTS, DISTANCE_CHANGED, sample, sizeof(*sample), 0);
+            state->reported = true;
+            state->last_cm = d;
+        }
+    }
 }
 
 
 static void i_read_the_god_damn_datas_and_fuking_dont_call_back(void* arg){
 
-    adc_task_params_t* params = (adc_task_params_t*) arg;
-    adc_oneshot_unit_handle_t adc_handle = params->adc_handle;
-    esp_event_loop_handle_t loop = params->loop;
+    struct GP2Y0A41SK0F *gp2 = (struct GP2Y0A41SK0F *) arg;
+    esp_event_loop_handle_t loop = gp2->loop;
 
-    float adc_reading = 0.0f;
-    float distance = 0.0f;
-    float suma = 0.0f;
-    int count = 0;
-    int retries = 0;
-    const int max_retries = CONFIG_CONS_N * 10;
+    GP2Y0A41SK0F_sample_t samples[GP2_MAX_SENSORS];
 
     while(1){
-        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(gp2->tick, portMAX_DELAY);
+        if (gp2->stopping){
+            break;
+        }
 
-        suma = 0.0f;
-        count = 0;
-        retries = 0;
+        esp_err_t ret = GP2Y0A41SK0F_measure_frame(gp2, samples);
+        if (ret != ESP_OK){
+            ESP_LOGW(TAG, "burst failed: %s", esp_err_to_name(ret));
+            continue;
+        }
 
-        while(count < CONFIG_CONS_N && retries < max_retries){
+        int64_t now = esp_timer_get_time();
+        for (size_t i = 0; i < gp2_sensors; i++){
+            samples[i].timestamp_us = now;
+        }
 
-            adc_reading = read_voltage(adc_handle);
-        
-            if(adc_reading > 0.005f && adc_reading < 3.2f) {  //the rest accroding to the graph are readings senselesses
-                distance = read_distance(adc_reading);
-                suma += distance;
-                count++;
-            }
+        for (size_t i = 0; i < GP2_MAX_SUBSCRIBERS && gp2->subscribers[i].cb != NULL; i++){
+            gp2->subscribers[i].cb(samples, gp2_sensors, gp2->subscribers[i].arg);
+        }
 
-            retries++;
-        
+        // Whole ticks only, so readers never see half a sample
+        size_t bytes = gp2_sensors * sizeof(GP2Y0A41SK0F_sample_t);
+        if (xStreamBufferSpacesAvailable(gp2->stream) >= bytes){
+            xStreamBufferSend(gp2->stream, samples, bytes, 0);
         }
-        float average = suma / CONFIG_CONS_N;
 
-        xQueueSend(distance_queue, &average, 0); 
+        ESP_LOGD(TAG, "GP2 posted a data");
 
-        ESP_LOGI(TAG, "GP2 posted a data");
+        // The sample travels inside the events, a full loop drops them rather than stall the sampling
+        for (size_t i = 0; loop != NULL && i < gp2_sensors; i++){
+#if CONFIG_GP2_POST_EVENTS
+            esp_event_post_to(loop, PRAC5_EVENTS, DATA_READY, &samples[i], sizeof(GP2Y0A41SK0F_sample_t), 0);
+#endif
+            GP2Y0A41SK0F_post_changes(gp2, &samples[i]);
+        }
 
-        esp_event_post_to(loop, PRAC5_EVENTS, DATA_READY, NULL, 0, portMAX_DELAY);
+    }
 
+    // Nothing of gp2 is touched past this point, GP2Y0A41SK0F_stop() may already be reusing it
+    xSemaphoreGive(gp2->done);
+    vTaskDelete(NULL);
+}
+
+
+// The mean of N codes has variance / N: pick the power of two N that brings the noisiest sensor to the target
+static void GP2Y0A41SK0F_adapt(struct GP2Y0A41SK0F *gp2, uint32_t variance){
+    const uint32_t target = CONFIG_GP2_ADAPTIVE_NOISE * CONFIG_GP2_ADAPTIVE_NOISE;
+    size_t n = CONFIG_GP2_MIN_N;
+
+    while (n < CONFIG_GP2_MAX_N && variance > target * n){
+        n *= 2;
+    }
+    if (n > CONFIG_GP2_MAX_N){
+        n = CONFIG_GP2_MAX_N;
     }
 
+    if (n != gp2->burst_n){
+        ESP_LOGD(TAG, "burst %u -> %u codes", (unsigned) gp2->burst_n, (unsigned) n);
+        gp2->burst_n = n;
+    }
 }
 
 
-float read_distance(float voltage){
-    float equ_a = atof(CONFIG_EQU_A);
-    float equ_b = atof(CONFIG_EQU_B);
-    float equ_c = atof(CONFIG_EQU_C);
+// Whole burst stays in integer codes, the curve is applied once to the filtered code
+static float GP2Y0A41SK0F_reduce(struct GP2Y0A41SK0F *gp2, size_t sensor, uint16_t *codes, size_t count, size_t n, GP2Y0A41SK0F_quality_t *quality){
+
+    uint32_t code = GP2Y0A41SK0F_filter_window(codes, count, n, quality);
+    if (!quality->ok){
+        return NAN;
+    }
+
+#if CONFIG_GP2_EMA_SHIFT > 0
+    int32_t scaled = (int32_t) code << CONFIG_GP2_EMA_SHIFT;
+    int32_t *state = &gp2->ema_state[sensor];
+    if (*state < 0){
+        *state = scaled;
+    }
+    else{
+        *state += (scaled - *state) >> CONFIG_GP2_EMA_SHIFT;
+    }
+    code = *state >> CONFIG_GP2_EMA_SHIFT;
+#endif
+
+    return GP2Y0A41SK0F_code_to_distance(code);
+}
+
+
+esp_err_t GP2Y0A41SK0F_measure(GP2Y0A41SK0F_handle_t gp2, float *distance){
+
+    uint16_t codes[CONFIG_GP2_MAX_N];
+    GP2Y0A41SK0F_quality_t quality;
+    const size_t n = gp2->burst_n;
+    int raw = 0;
+    size_t count = 0;
+    size_t retries = 0;
+    // A window still short after twice its size is flagged, not retried further
+    const size_t max_retries = n * 2;
+
+    // The task's captures hold ADC1 and its filter state is not shared; the stream has its samples
+    if (gp2->task != NULL){
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    while(count < n && retries < max_retries){
+
+        esp_err_t ret = ADC_read_raw(gp2->adc_handle, gp2_channels[0], &raw);
+        if (ret != ESP_OK){
+            return ret;
+        }
     
-    float distance = equ_a / (voltage - equ_c) - equ_b;
+        if(GP2Y0A41SK0F_code_valid(raw)) {
+            codes[count++] = raw;
+        }
+
+        retries++;
+    
+    }
+    // The oneshot path reads the first sensor, the channel ADC_init() was given
+    *distance = GP2Y0A41SK0F_reduce(gp2, 0, codes, count, n, &quality);
+
+    return quality.ok ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
+
+
+#if CONFIG_GP2_TRACE_LOG
+// One line per sensor and frame, "sensor: codes", the format of test/traces
+static void GP2Y0A41SK0F_trace(size_t sensor, const uint16_t *row, size_t count){
+    printf("%u:", (unsigned) sensor);
+    for (size_t i = 0; i < count; i++){
+        printf(" %u", row[i]);
+    }
+    printf("\n");
+}
+#endif
+
+
+esp_err_t GP2Y0A41SK0F_measure_frame(GP2Y0A41SK0F_handle_t gp2, GP2Y0A41SK0F_sample_t *results){
+
+    uint16_t *raw = gp2->burst_raw;
+    uint16_t (*codes)[CONFIG_GP2_MAX_N] = gp2->burst_codes;
+    size_t samples[GP2_MAX_SENSORS];
+    size_t count[GP2_MAX_SENSORS] = { 0 };
+    ADC_continuous_handle_t adc = gp2->adc_cont;
+    const size_t n = gp2->burst_n;
+    size_t done = 0;
+    int frames = 0;
+
+    esp_err_t ret = ADC_continuous_set_frame(adc, n);
+    if (ret != ESP_OK){
+        return ret;
+    }
+
+    // Same filtering as GP2Y0A41SK0F_measure(), but a frame holds a whole burst of every sensor
+    while(done < gp2_sensors && frames < 2){
+
+        ret = ADC_continuous_capture(adc, raw, samples);
+        if (ret != ESP_OK){
+            return ret;
+        }
+
+        done = 0;
+        for (size_t s = 0; s < gp2_sensors; s++){
+            const uint16_t *row = &raw[s * n];
+#if CONFIG_GP2_TRACE_LOG
+            GP2Y0A41SK0F_trace(s, row, samples[s]);
+#endif
+
+            for (size_t i = 0; i < samples[s] && count[s] < n; i++){
+                if(GP2Y0A41SK0F_code_valid(row[i])) {
+                    codes[s][count[s]++] = row[i];
+                }
+            }
+            done += count[s] == n;
+        }
+
+        frames++;
+    }
+
+    uint32_t variance = 0;
+    bool any_ok = false;
+    for (size_t s = 0; s < gp2_sensors; s++){
+        GP2Y0A41SK0F_sample_t *r = &results[s];
+
+        r->sensor = s;
+        r->distance = GP2Y0A41SK0F_reduce(gp2, s, codes[s], count[s], n, &r->quality);
+        if (r->quality.ok){
+            any_ok = true;
+            if (r->quality.variance > variance){
+                variance = r->quality.variance;
+            }
+        }
+    }
+
+    // A frame with no good window says nothing about the noise, the burst stays as it is
+    if (gp2->burst_adaptive && any_ok){
+        GP2Y0A41SK0F_adapt(gp2, variance);
+    }
+
+    return ESP_OK;
+}
+
 
-    return distance;
+static void GP2Y0A41SK0F_parse_channels(){
+    const char *p = CONFIG_GP2_CHANNELS;
+    char *end;
+
+    gp2_sensors = 0;
+    while (*p != '\0' && gp2_sensors < GP2_MAX_SENSORS){
+        long channel = strtol(p, &end, 10);
+        if (end == p){
+            p++;    // separator
+            continue;
+        }
+        gp2_channels[gp2_sensors++] = channel;
+        p = end;
+    }
+
+    if (gp2_sensors == 0){
+        gp2_channels[gp2_sensors++] = CONFIG_NEO_ADC_CHANNL;
+    }
 }
 
 
 adc_oneshot_unit_handle_t GP2Y0A41SK0F_init(){
-    adc_oneshot_unit_handle_t adc_handle = ADC_init();
+    GP2Y0A41SK0F_parse_channels();
+    adc_oneshot_unit_handle_t adc_handle = ADC_init(gp2_channels[0]);
+    GP2Y0A41SK0F_build_curve();
     return adc_handle;
 }
 
 
-void GP2Y0A41SK0F_start(adc_oneshot_unit_handle_t adc_handle, esp_event_loop_handle_t loop){
-    
-    adc_task_params_t* task_params = malloc(sizeof(adc_task_params_t));
-    task_params->adc_handle = adc_handle;
-    task_params->loop = loop;
+size_t GP2Y0A41SK0F_sensor_count(){
+    return gp2_sensors;
+}
+
+
+// Forgets the EMA and the trigger zones and distances: after a stop they describe a scene that may be gone
+static void GP2Y0A41SK0F_reset_history(struct GP2Y0A41SK0F *gp2){
+
+    memset(gp2->trigger_state, 0, sizeof(gp2->trigger_state));
+#if CONFIG_GP2_EMA_SHIFT > 0
+    for (size_t s = 0; s < GP2_MAX_SENSORS; s++){
+        gp2->ema_state[s] = -1;
+    }
+#endif
+}
+
+esp_err_t GP2Y0A41SK0F_create(adc_oneshot_unit_handle_t adc_handle, esp_event_loop_handle_t loop, GP2Y0A41SK0F_handle_t *handle_ret){
 
-    distance_queue = xQueueCreate(12, sizeof(float));
+    struct GP2Y0A41SK0F *gp2 = NULL;
 
-    xTaskCreate(i_read_the_god_damn_datas_and_fuking_dont_call_back, "ADC_GP2_reading", 4096, task_params, 5, &adc_gp2_handle);
+    if (handle_ret == NULL){
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The channels come from GP2Y0A41SK0F_init()
+    if (gp2_sensors == 0){
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    for (size_t i = 0; i < GP2_MAX_INSTANCES; i++){
+        if (!gp2_pool[i].used){
+            gp2 = &gp2_pool[i];
+            break;
+        }
+    }
+    if (gp2 == NULL){
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(gp2, 0, sizeof(*gp2));
+    gp2->adc_handle = adc_handle;
+    gp2->loop = loop;
+    gp2->period_ms = CONFIG_GP2_PERIOD_MS;
+    gp2->burst_n = CONFIG_CONS_N;
+#if CONFIG_GP2_ADAPTIVE
+    gp2->burst_adaptive = true;
+#endif
+    gp2->trigger = (GP2Y0A41SK0F_trigger_t) {
+        .near_cm = CONFIG_GP2_NEAR_MM / 10.0f,
+        .hysteresis_cm = CONFIG_GP2_HYSTERESIS_MM / 10.0f,
+        .delta_cm = CONFIG_GP2_DELTA_MM / 10.0f,
+    };
+    portMUX_INITIALIZE(&gp2->trigger_lock);
+    GP2Y0A41SK0F_reset_history(gp2);
+
+    esp_err_t ret = ADC_continuous_init(gp2_channels, gp2_sensors, CONFIG_GP2_MAX_N, &gp2->adc_cont);
+    if (ret != ESP_OK){
+        return ret;
+    }
 
     const esp_timer_create_args_t adc_timer_config = {
         .callback = &timer_callback,
+        .arg = gp2,
+        .name = "GP2",
     };
-    ESP_ERROR_CHECK(esp_timer_create(&adc_timer_config, &adc_timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(adc_timer, 1000000));
+    ret = esp_timer_create(&adc_timer_config, &gp2->timer);
+    if (ret != ESP_OK){
+        ADC_continuous_deinit(gp2->adc_cont);
+        return ret;
+    }
+
+    gp2->tick = xSemaphoreCreateBinaryStatic(&gp2->tick_buf);
+    gp2->done = xSemaphoreCreateBinaryStatic(&gp2->done_buf);
+    // One byte over, so whole ticks of GP2_STREAM_BYTES fit whatever the kernel keeps free
+    gp2->stream = xStreamBufferCreateStatic(GP2_STREAM_BYTES + 1, sizeof(GP2Y0A41SK0F_sample_t), gp2->stream_storage, &gp2->stream_buf);
+
+    gp2->used = true;
+    *handle_ret = gp2;
+
+    return ESP_OK;
+}
+
+esp_err_t GP2Y0A41SK0F_start(GP2Y0A41SK0F_handle_t gp2){
+
+    if (gp2->task != NULL){
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // A tick, samples or filter history left over from before the last stop
+    gp2->stopping = false;
+    xSemaphoreTake(gp2->tick, 0);
+    xStreamBufferReset(gp2->stream);
+    GP2Y0A41SK0F_reset_history(gp2);
+
+    // One tick of samples and the outlier scratch of reject_outliers() live on this stack
+    if (xTaskCreate(i_read_the_god_damn_datas_and_fuking_dont_call_back, "ADC_GP2_reading", 6144, gp2, 5, &gp2->task) != pdPASS){
+        gp2->task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = esp_timer_start_periodic(gp2->timer, (uint64_t) gp2->period_ms * 1000);
+    if (ret != ESP_OK){
+        GP2Y0A41SK0F_stop(gp2);
+        return ret;
+    }
 
     ESP_LOGI(TAG, "GP2Y0A41SK0F startted");
-    
+
+    return ESP_OK;
 }
 
-void GP2Y0A41SK0F_stop(){
-    ESP_ERROR_CHECK(esp_timer_stop(adc_timer));
-    ESP_ERROR_CHECK(esp_timer_delete(adc_timer));
-    adc_timer = NULL;
-    
-    vQueueDelete(distance_queue);
-    distance_queue = NULL;
-    
+esp_err_t GP2Y0A41SK0F_stop(GP2Y0A41SK0F_handle_t gp2){
+
+    // From a subscriber the join below would wait on itself
+    if (gp2->task == NULL || gp2->task == xTaskGetCurrentTaskHandle()){
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_timer_stop(gp2->timer);
+
+    // Joins the task: a burst in flight finishes first, then it gives done and deletes itself
+    gp2->stopping = true;
+    xSemaphoreGive(gp2->tick);
+    xSemaphoreTake(gp2->done, portMAX_DELAY);
+    gp2->task = NULL;
+
     ESP_LOGI(TAG, "GP2Y0A41SK0F stopped");
+
+    return ESP_OK;
+}
+
+esp_err_t GP2Y0A41SK0F_destroy(GP2Y0A41SK0F_handle_t gp2){
+
+    // From a subscriber the task would go on using what is freed below
+    if (gp2->task != NULL && GP2Y0A41SK0F_stop(gp2) != ESP_OK){
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_timer_delete(gp2->timer);
+    ADC_continuous_deinit(gp2->adc_cont);
+    vStreamBufferDelete(gp2->stream);
+    vSemaphoreDelete(gp2->tick);
+    vSemaphoreDelete(gp2->done);
+
+    gp2->used = false;
+
+    return ESP_OK;
+}
+
+esp_err_t GP2Y0A41SK0F_set_period(GP2Y0A41SK0F_handle_t gp2, uint32_t ms){
+
+    if (ms == 0){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    gp2->period_ms = ms;
+
+    if (gp2->task != NULL){
+        return esp_timer_restart(gp2->timer, (uint64_t) ms * 1000);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t GP2Y0A41SK0F_set_burst(GP2Y0A41SK0F_handle_t gp2, size_t n, bool adaptive){
+
+    if (n == 0 || n > CONFIG_GP2_MAX_N){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Picked up by the next burst
+    gp2->burst_n = n;
+    gp2->burst_adaptive = adaptive;
+
+    return ESP_OK;
+}
+
+size_t GP2Y0A41SK0F_get_burst(GP2Y0A41SK0F_handle_t gp2){
+    return gp2->burst_n;
+}
+
+esp_err_t GP2Y0A41SK0F_set_trigger(GP2Y0A41SK0F_handle_t gp2, const GP2Y0A41SK0F_trigger_t *config){
+
+    if (config == NULL || config->near_cm < 0 || config->hysteresis_cm < 0 || config->delta_cm < 0){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&gp2->trigger_lock);
+    gp2->trigger = *config;
+    portEXIT_CRITICAL(&gp2->trigger_lock);
+
+    return ESP_OK;
 }
 
-QueueHandle_t get_distance_handle(){
-    return distance_queue;
+esp_err_t GP2Y0A41SK0F_subscribe(GP2Y0A41SK0F_handle_t gp2, GP2Y0A41SK0F_cb_t cb, void *arg){
+
+    if (cb == NULL){
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < GP2_MAX_SUBSCRIBERS; i++){
+        if (gp2->subscribers[i].cb == NULL){
+            gp2->subscribers[i].arg = arg;
+            gp2->subscribers[i].cb = cb;
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NO_MEM;
+}
+
+size_t GP2Y0A41SK0F_read(GP2Y0A41SK0F_handle_t gp2, GP2Y0A41SK0F_sample_t *samples, size_t max_samples, TickType_t timeout){
+
+    size_t bytes = xStreamBufferReceive(gp2->stream, samples, max_samples * sizeof(GP2Y0A41SK0F_sample_t), timeout);
+
+    return bytes / sizeof(GP2Y0A41SK0F_sample_t);
 }
\ No newline at end of file
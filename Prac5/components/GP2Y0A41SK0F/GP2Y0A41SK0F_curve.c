@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include "ADC.h"
+#include "GP2Y0A41SK0F.h"
+
+// Curve constants, parsed from the Kconfig strings once by GP2Y0A41SK0F_init()
+static float equ_a, equ_b, equ_c;
+
+// Distance every 16 raw codes, interpolated in between: within 0.06 cm of the formula from 4 to 30 cm and
+// 0.12 cm up to 40 cm, about one 1 mV step of the calibration table there (test/gp2_lut_bench.c)
+#define GP2_LUT_SHIFT   4
+#define GP2_LUT_SIZE    ((4096 >> GP2_LUT_SHIFT) + 1)
+static float distance_lut[GP2_LUT_SIZE];
+
+// Raw codes inside the 0.005 V to 3.2 V window, the rest according to the graph are readings senselesses
+static uint16_t code_min, code_max;
+
+
+// Inside the window of GP2Y0A41SK0F_build_curve()
+bool GP2Y0A41SK0F_code_valid(int raw){
+    return raw >= code_min && raw <= code_max;
+}
+
+
+float read_distance(float voltage){
+    
+    float distance = equ_a / (voltage - equ_c) - equ_b;
+
+    return distance;
+}
+
+
+float GP2Y0A41SK0F_code_to_distance(uint32_t code){
+    const int shift = GP2_LUT_SHIFT + GP2_CODE_FRAC_BITS;
+    uint32_t i = code >> shift;
+    float frac = (float) (code & ((1 << shift) - 1)) / (1 << shift);
+
+    if (i >= GP2_LUT_SIZE - 1){
+        return distance_lut[GP2_LUT_SIZE - 1];
+    }
+
+    return distance_lut[i] + (distance_lut[i + 1] - distance_lut[i]) * frac;
+}
+
+
+float GP2Y0A41SK0F_raw_to_distance(uint16_t raw){
+    return GP2Y0A41SK0F_code_to_distance((uint32_t) raw << GP2_CODE_FRAC_BITS);
+}
+
+
+// Needs the calibration table, so it runs after ADC_init()
+void GP2Y0A41SK0F_build_curve(){
+    equ_a = atof(CONFIG_EQU_A);
+    equ_b = atof(CONFIG_EQU_B);
+    equ_c = atof(CONFIG_EQU_C);
+
+    // The last node sits at code 4096, one past the ADC range: it takes the value of 4095
+    for (int i = 0; i < GP2_LUT_SIZE; i++){
+        int raw = i << GP2_LUT_SHIFT;
+        distance_lut[i] = read_distance(ADC_raw_to_voltage(raw < 4095 ? raw : 4095));
+    }
+
+    code_min = 4095;
+    code_max = 0;
+    for (int raw = 0; raw < 4096; raw++){
+        float voltage = ADC_raw_to_voltage(raw);
+        if (voltage > 0.005f && voltage < 3.2f){
+            code_min = raw < code_min ? raw : code_min;
+            code_max = raw;
+        }
+    }
+}
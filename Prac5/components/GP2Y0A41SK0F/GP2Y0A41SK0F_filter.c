@@ -0,0 +1,115 @@
+#include "GP2Y0A41SK0F.h"
+
+// Bursts are CONFIG_CONS_N codes long, insertion sort is all they need
+static void sort_codes(uint16_t *codes, size_t count){
+    for (size_t i = 1; i < count; i++){
+        uint16_t code = codes[i];
+        size_t j = i;
+        while (j > 0 && codes[j - 1] > code){
+            codes[j] = codes[j - 1];
+            j--;
+        }
+        codes[j] = code;
+    }
+}
+
+// Sorts the codes and keeps those within CONFIG_GP2_OUTLIER_K scaled MADs of the median, returns how many
+size_t GP2Y0A41SK0F_reject_outliers(uint16_t *codes, size_t count){
+
+    if (count < 3 || CONFIG_GP2_OUTLIER_K == 0){
+        return count;
+    }
+
+    sort_codes(codes, count);
+    uint16_t median = codes[count / 2];
+
+    // Distances to the median, sorted to take their median too
+    uint16_t dev[CONFIG_GP2_MAX_N];
+    for (size_t i = 0; i < count; i++){
+        dev[i] = codes[i] > median ? codes[i] - median : median - codes[i];
+    }
+    sort_codes(dev, count);
+    uint32_t mad = dev[count / 2];
+
+    // 1.4826 MAD estimates the standard deviation of Gaussian noise; quantised bursts can have MAD 0
+    uint32_t limit = (CONFIG_GP2_OUTLIER_K * 14826 * mad + 9999) / 10000;
+    if (limit < 2){
+        limit = 2;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++){
+        uint32_t d = codes[i] > median ? codes[i] - median : median - codes[i];
+        if (d <= limit){
+            codes[kept++] = codes[i];
+        }
+    }
+
+    return kept;
+}
+
+// Sample variance of a burst, in squared codes
+uint32_t GP2Y0A41SK0F_code_variance(const uint16_t *codes, size_t count){
+
+    if (count < 2){
+        return 0;
+    }
+
+    uint32_t sum = 0;
+    uint64_t squares = 0;
+    for (size_t i = 0; i < count; i++){
+        sum += codes[i];
+        squares += (uint32_t) codes[i] * codes[i];
+    }
+
+    return ((uint64_t) count * squares - (uint64_t) sum * sum) / ((uint64_t) count * (count - 1));
+}
+
+// Reduces a burst of valid raw codes to one code with GP2_CODE_FRAC_BITS fractional bits, codes may be reordered
+uint32_t GP2Y0A41SK0F_filter_codes(uint16_t *codes, size_t count){
+
+    if (count == 0){
+        return 0;
+    }
+
+#if CONFIG_GP2_FILTER_MEDIAN
+    sort_codes(codes, count);
+
+    // Even bursts average the middle pair, the fractional bit keeps the half code
+    return ((uint32_t) codes[(count - 1) / 2] + codes[count / 2]) << (GP2_CODE_FRAC_BITS - 1);
+#else
+    size_t first = 0;
+    size_t last = count;
+
+#if CONFIG_GP2_FILTER_TRIMMED
+    sort_codes(codes, count);
+
+    first = count * CONFIG_GP2_TRIM_PERCENT / 100;
+    last = count - first;
+#endif
+
+    uint32_t sum = 0;
+    for (size_t i = first; i < last; i++){
+        sum += codes[i];
+    }
+
+    size_t n = last - first;
+    return ((sum << GP2_CODE_FRAC_BITS) + n / 2) / n;
+#endif
+}
+
+uint32_t GP2Y0A41SK0F_filter_window(uint16_t *codes, size_t count, size_t n, GP2Y0A41SK0F_quality_t *quality){
+
+    quality->valid = count;
+    count = GP2Y0A41SK0F_reject_outliers(codes, count);
+    quality->used = count;
+    quality->variance = GP2Y0A41SK0F_code_variance(codes, count);
+
+    // Too few codes left: an average of them would not be the distance, flag the window instead
+    quality->ok = count > 0 && count * 100 >= n * CONFIG_GP2_MIN_VALID_PERCENT;
+    if (!quality->ok){
+        return 0;
+    }
+
+    return GP2Y0A41SK0F_filter_codes(codes, count);
+}
@@ -0,0 +1,34 @@
+#include "GP2Y0A41SK0F.h"
+
+static esp_err_t GP2Y0A41SK0F_sensor_fetch(neo_sensor_t *sensor, neo_sample_t *samples, size_t max_samples, size_t *count){
+
+    float distance;
+
+    if (max_samples < 1){
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = GP2Y0A41SK0F_measure((GP2Y0A41SK0F_handle_t) sensor->ctx, &distance);
+    if (ret != ESP_OK){
+        return ret;
+    }
+
+    samples[0] = (neo_sample_t) { .kind = NEO_SAMPLE_DISTANCE, .value = { distance } };
+    *count = 1;
+
+    return ESP_OK;
+}
+
+static const neo_sensor_ops_t GP2Y0A41SK0F_sensor_ops = {
+    .fetch = GP2Y0A41SK0F_sensor_fetch,
+};
+
+void GP2Y0A41SK0F_sensor_bind(GP2Y0A41SK0F_handle_t gp2, uint8_t id, neo_sensor_t *sensor){
+    *sensor = (neo_sensor_t) {
+        .ops = &GP2Y0A41SK0F_sensor_ops,
+        .name = "GP2Y0A41SK0F",
+        .ctx = gp2,
+        .conversion_us = 0,
+        .id = id,
+    };
+}
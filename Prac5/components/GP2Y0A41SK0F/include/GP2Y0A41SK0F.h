@@ -1,26 +1,94 @@
+#pragma once
+
+#include <stdbool.h>
 #include "ADC.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+#include "freertos/stream_buffer.h"
 
 #include "esp_event.h"
 
+#include "neo_sensor.h"
+
 ESP_EVENT_DECLARE_BASE(PRAC5_EVENTS);
 
+// Event data: the GP2Y0A41SK0F_sample_t
 enum {
-    DATA_READY,
+    DATA_READY,         // every output, with CONFIG_GP2_POST_EVENTS
+    DISTANCE_CHANGED,   // moved delta_cm or more since the last one
+    DISTANCE_NEAR,      // went under near_cm
+    DISTANCE_FAR,       // went back over near_cm + hysteresis_cm
 };
 
+// ADC1 has 8 channels on the ESP32
+#define GP2_MAX_SENSORS     8
+
+#define GP2_MAX_SUBSCRIBERS 4
+
+typedef struct {
+    uint16_t valid;         // codes inside the voltage window
+    uint16_t used;          // valid codes left after the median/MAD outlier cut
+    uint32_t variance;      // of the used codes, squared raw codes
+    bool ok;                // used reaches CONFIG_GP2_MIN_VALID_PERCENT of the burst
+} GP2Y0A41SK0F_quality_t;
+
 typedef struct {
-    adc_oneshot_unit_handle_t adc_handle;
-    esp_event_loop_handle_t loop;
-} adc_task_params_t;
+    int64_t timestamp_us;   // end of the burst, esp_timer time
+    uint8_t sensor;         // position of its channel in CONFIG_GP2_CHANNELS
+    float distance;         // NAN when the window is not ok
+    GP2Y0A41SK0F_quality_t quality;
+} GP2Y0A41SK0F_sample_t;
+
+// Change detection for the events, 0 disables a check
+typedef struct {
+    float near_cm;
+    float hysteresis_cm;
+    float delta_cm;
+} GP2Y0A41SK0F_trigger_t;
+
+// Runs in the GP2 task with the samples of one tick, one per sensor; it must not block
+typedef void (*GP2Y0A41SK0F_cb_t)(const GP2Y0A41SK0F_sample_t *samples, size_t count, void *arg);
+
+// One sampling instance: its timer, task, stream and settings, from a static pool
+typedef struct GP2Y0A41SK0F *GP2Y0A41SK0F_handle_t;
+
 
+// Filtered codes keep 4 fractional bits: raw code * 16
+#define GP2_CODE_FRAC_BITS  4
 
-static void i_read_the_god_damn_datas_and_fuking_dont_call_back(void* arg);
 float read_distance(float voltage);
+float GP2Y0A41SK0F_raw_to_distance(uint16_t raw);
+float GP2Y0A41SK0F_code_to_distance(uint32_t code);
+// LUT and validity window from the ADC calibration table, done by GP2Y0A41SK0F_init()
+void GP2Y0A41SK0F_build_curve();
+bool GP2Y0A41SK0F_code_valid(int raw);
+uint32_t GP2Y0A41SK0F_filter_codes(uint16_t *codes, size_t count);
+uint32_t GP2Y0A41SK0F_code_variance(const uint16_t *codes, size_t count);
+size_t GP2Y0A41SK0F_reject_outliers(uint16_t *codes, size_t count);
+// One burst of count valid codes out of n: outlier cut, quality, then the filtered code, only meaningful if quality->ok
+uint32_t GP2Y0A41SK0F_filter_window(uint16_t *codes, size_t count, size_t n, GP2Y0A41SK0F_quality_t *quality);
+// One oneshot burst of the first sensor; ESP_ERR_INVALID_STATE while started, read the stream instead
+esp_err_t GP2Y0A41SK0F_measure(GP2Y0A41SK0F_handle_t gp2, float *distance);
+// Fills one result per sensor, all but the timestamp; it shares the instance buffers with the task, so only while stopped
+esp_err_t GP2Y0A41SK0F_measure_frame(GP2Y0A41SK0F_handle_t gp2, GP2Y0A41SK0F_sample_t *results);
+size_t GP2Y0A41SK0F_sensor_count();
 adc_oneshot_unit_handle_t GP2Y0A41SK0F_init();
-void GP2Y0A41SK0F_start(adc_oneshot_unit_handle_t adc_handle, esp_event_loop_handle_t loop);
-void GP2Y0A41SK0F_stop();
-QueueHandle_t get_distance_handle();
\ No newline at end of file
+// After GP2Y0A41SK0F_init(); loop may be NULL for no events. ESP_ERR_NO_MEM once the pool is used up
+esp_err_t GP2Y0A41SK0F_create(adc_oneshot_unit_handle_t adc_handle, esp_event_loop_handle_t loop, GP2Y0A41SK0F_handle_t *handle_ret);
+// Each start begins with no EMA or trigger history, the first tick only sets the NEAR/FAR side
+esp_err_t GP2Y0A41SK0F_start(GP2Y0A41SK0F_handle_t gp2);
+// Returns once the task has finished its burst and exited, so start can follow right away; not from a subscriber
+esp_err_t GP2Y0A41SK0F_stop(GP2Y0A41SK0F_handle_t gp2);
+// Stops if needed and gives the instance back to the pool; ESP_ERR_INVALID_STATE from a subscriber
+esp_err_t GP2Y0A41SK0F_destroy(GP2Y0A41SK0F_handle_t gp2);
+esp_err_t GP2Y0A41SK0F_set_period(GP2Y0A41SK0F_handle_t gp2, uint32_t ms);
+// n codes per burst from the next tick on; adaptive lets each burst pick the next n from its noise
+esp_err_t GP2Y0A41SK0F_set_burst(GP2Y0A41SK0F_handle_t gp2, size_t n, bool adaptive);
+size_t GP2Y0A41SK0F_get_burst(GP2Y0A41SK0F_handle_t gp2);
+esp_err_t GP2Y0A41SK0F_set_trigger(GP2Y0A41SK0F_handle_t gp2, const GP2Y0A41SK0F_trigger_t *config);
+// Subscribers stay registered across stop/start
+esp_err_t GP2Y0A41SK0F_subscribe(GP2Y0A41SK0F_handle_t gp2, GP2Y0A41SK0F_cb_t cb, void *arg);
+// Batch read of the samples buffered since the last call, waits up to timeout for the first one
+size_t GP2Y0A41SK0F_read(GP2Y0A41SK0F_handle_t gp2, GP2Y0A41SK0F_sample_t *samples, size_t max_samples, TickType_t timeout);
+void GP2Y0A41SK0F_sensor_bind(GP2Y0A41SK0F_handle_t gp2, uint8_t id, neo_sensor_t *sensor);
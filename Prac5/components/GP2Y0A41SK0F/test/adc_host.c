@@ -0,0 +1,16 @@
+#include "ADC.h"
+
+// The table ADC.c falls back to without eFuse calibration: linear, 3100 mV full scale
+int ADC_raw_to_mv(int adc_raw){
+    if (adc_raw < 0){
+        adc_raw = 0;
+    }
+    else if (adc_raw > 4095){
+        adc_raw = 4095;
+    }
+    return adc_raw * 3100 / 4095;
+}
+
+float ADC_raw_to_voltage(int adc_raw){
+    return ADC_raw_to_mv(adc_raw) / 1000.0f;
+}
@@ -0,0 +1,158 @@
+// Host test of the burst filter: every trace file goes through the code path of GP2Y0A41SK0F_measure(),
+// validity window, GP2Y0A41SK0F_filter_window() and the LUT, and each burst is checked against its truth.
+//
+// Trace format, one burst per line as CONFIG_GP2_TRACE_LOG prints it:
+//   # comment
+//   @ <cm>       true distance of the bursts below; "@ -" expects them flagged
+//   0: <codes>   raw codes of one burst, the "sensor:" prefix is optional
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "GP2Y0A41SK0F.h"
+
+// Off by at most this much, or this fraction of the distance if larger
+#define TOLERANCE_CM        0.3f
+#define TOLERANCE_REL       0.02f
+
+#define MAX_LINE            8192
+
+typedef struct {
+    size_t bursts;
+    size_t failed;
+    float worst_cm;         // largest error of the bursts that should be ok
+    float worst_mean_cm;    // same, with a plain mean of the valid codes
+} trace_stats_t;
+
+static float plain_mean_distance(const uint16_t *codes, size_t count){
+    uint32_t sum = 0;
+    for (size_t i = 0; i < count; i++){
+        sum += codes[i];
+    }
+    return count > 0 ? GP2Y0A41SK0F_code_to_distance((sum << GP2_CODE_FRAC_BITS) / count) : NAN;
+}
+
+static void check_burst(const char *file, int line, float truth, const uint16_t *raw, size_t n, trace_stats_t *stats){
+    uint16_t codes[CONFIG_GP2_MAX_N];
+    GP2Y0A41SK0F_quality_t quality;
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; i++){
+        if (GP2Y0A41SK0F_code_valid(raw[i])){
+            codes[count++] = raw[i];
+        }
+    }
+
+    float mean_cm = plain_mean_distance(codes, count);
+    uint32_t code = GP2Y0A41SK0F_filter_window(codes, count, n, &quality);
+    float distance = quality.ok ? GP2Y0A41SK0F_code_to_distance(code) : NAN;
+
+    stats->bursts++;
+
+    if (isnan(truth)){
+        if (quality.ok){
+            printf("%s:%d: window should be flagged, got %.2f cm from %u of %u codes\n",
+                   file, line, distance, quality.used, (unsigned) n);
+            stats->failed++;
+        }
+        return;
+    }
+
+    float error = fabsf(distance - truth);
+    float tolerance = fmaxf(TOLERANCE_CM, TOLERANCE_REL * truth);
+    if (!quality.ok || !(error <= tolerance)){
+        printf("%s:%d: expected %.2f cm, got %.2f cm (ok %d, %u valid, %u used, variance %u)\n",
+               file, line, truth, distance, quality.ok, quality.valid, quality.used, (unsigned) quality.variance);
+        stats->failed++;
+        return;
+    }
+
+    stats->worst_cm = fmaxf(stats->worst_cm, error);
+    stats->worst_mean_cm = fmaxf(stats->worst_mean_cm, fabsf(mean_cm - truth));
+}
+
+static int run_trace(const char *path, trace_stats_t *stats){
+    static char text[MAX_LINE];
+    uint16_t raw[CONFIG_GP2_MAX_N];
+    float truth = NAN;
+    int line = 0;
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL){
+        perror(path);
+        return -1;
+    }
+
+    while (fgets(text, sizeof(text), f) != NULL){
+        char *p = text;
+        line++;
+
+        while (*p == ' ' || *p == '\t'){
+            p++;
+        }
+        if (*p == '#' || *p == '\n' || *p == '\0'){
+            continue;
+        }
+        if (*p == '@'){
+            p++;
+            while (*p == ' '){
+                p++;
+            }
+            truth = *p == '-' ? NAN : strtof(p, NULL);
+            continue;
+        }
+
+        char *colon = strchr(p, ':');
+        if (colon != NULL){
+            p = colon + 1;
+        }
+
+        size_t n = 0;
+        char *end;
+        for (long code = strtol(p, &end, 10); end != p; code = strtol(p, &end, 10)){
+            if (n == CONFIG_GP2_MAX_N){
+                printf("%s:%d: burst longer than CONFIG_GP2_MAX_N (%d)\n", path, line, CONFIG_GP2_MAX_N);
+                fclose(f);
+                return -1;
+            }
+            raw[n++] = code;
+            p = end;
+        }
+
+        if (n > 0){
+            check_burst(path, line, truth, raw, n, stats);
+        }
+    }
+
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char **argv){
+
+    int failed = 0;
+
+    if (argc < 2){
+        printf("usage: %s trace...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    GP2Y0A41SK0F_build_curve();
+
+    printf("%-24s %7s %7s %11s %13s\n", "trace", "bursts", "failed", "worst cm", "plain mean cm");
+    for (int i = 1; i < argc; i++){
+        trace_stats_t stats = { 0 };
+        const char *name = strrchr(argv[i], '/') != NULL ? strrchr(argv[i], '/') + 1 : argv[i];
+
+        if (run_trace(argv[i], &stats) != 0 || stats.bursts == 0){
+            failed = 1;
+            continue;
+        }
+        printf("%-24s %7u %7u %11.3f %13.3f\n", name, (unsigned) stats.bursts, (unsigned) stats.failed,
+               stats.worst_cm, stats.worst_mean_cm);
+        failed |= stats.failed > 0;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
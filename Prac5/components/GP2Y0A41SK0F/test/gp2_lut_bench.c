@@ -0,0 +1,148 @@
+// Host benchmark of the voltage to distance conversion: the LUT of GP2Y0A41SK0F_build_curve()
+// against the formula it replaced, read_distance() with three atof() per sample.
+// Throughput is only printed; the run fails if the LUT strays from the formula by more than MAX_ERROR_CM.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "GP2Y0A41SK0F.h"
+
+// Checked over the sensor range, 4 to 30 cm, and only printed for a margin past it. The bound is about
+// one step of the 1 mV calibration table there: the formula itself moves that much between two codes
+#define RANGE_MIN_CM    4.0f
+#define RANGE_MAX_CM    30.0f
+#define MARGIN_MAX_CM   40.0f
+#define MAX_ERROR_CM    0.08f
+
+#define PASSES          200
+#define BURST           CONFIG_CONS_N
+
+// read_distance() before the LUT
+static float formula_per_sample(float voltage){
+    float equ_a = atof(CONFIG_EQU_A);
+    float equ_b = atof(CONFIG_EQU_B);
+    float equ_c = atof(CONFIG_EQU_C);
+
+    float distance = equ_a / (voltage - equ_c) - equ_b;
+
+    return distance;
+}
+
+static double now_s(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(){
+
+    static uint16_t codes[4096];
+    size_t count = 0;
+    volatile float sink = 0;
+    double t0, t_old, t_parsed, t_lut, t_burst_old, t_burst_lut;
+
+    GP2Y0A41SK0F_build_curve();
+
+    // Every code the validity window lets through, in a shuffled order so the LUT is not walked in sequence
+    for (int raw = 0; raw < 4096; raw++){
+        if (GP2Y0A41SK0F_code_valid(raw)){
+            codes[count++] = raw;
+        }
+    }
+    srand(42);
+    for (size_t i = count - 1; i > 0; i--){
+        size_t j = rand() % (i + 1);
+        uint16_t t = codes[i];
+        codes[i] = codes[j];
+        codes[j] = t;
+    }
+
+    // Per sample: the old formula, the formula with the constants parsed once, the LUT
+    t0 = now_s();
+    for (int p = 0; p < PASSES; p++){
+        for (size_t i = 0; i < count; i++){
+            sink += formula_per_sample(ADC_raw_to_voltage(codes[i]));
+        }
+    }
+    t_old = now_s() - t0;
+
+    t0 = now_s();
+    for (int p = 0; p < PASSES; p++){
+        for (size_t i = 0; i < count; i++){
+            sink += read_distance(ADC_raw_to_voltage(codes[i]));
+        }
+    }
+    t_parsed = now_s() - t0;
+
+    t0 = now_s();
+    for (int p = 0; p < PASSES; p++){
+        for (size_t i = 0; i < count; i++){
+            sink += GP2Y0A41SK0F_raw_to_distance(codes[i]);
+        }
+    }
+    t_lut = now_s() - t0;
+
+    // Per burst: a distance per code averaged, against the codes averaged and one LUT lookup
+    const size_t bursts = count / BURST;
+    t0 = now_s();
+    for (int p = 0; p < PASSES; p++){
+        for (size_t b = 0; b < bursts; b++){
+            float sum = 0;
+            for (size_t i = 0; i < BURST; i++){
+                sum += formula_per_sample(ADC_raw_to_voltage(codes[b * BURST + i]));
+            }
+            sink += sum / BURST;
+        }
+    }
+    t_burst_old = now_s() - t0;
+
+    t0 = now_s();
+    for (int p = 0; p < PASSES; p++){
+        for (size_t b = 0; b < bursts; b++){
+            uint32_t sum = 0;
+            for (size_t i = 0; i < BURST; i++){
+                sum += codes[b * BURST + i];
+            }
+            sink += GP2Y0A41SK0F_code_to_distance((sum << GP2_CODE_FRAC_BITS) / BURST);
+        }
+    }
+    t_burst_lut = now_s() - t0;
+
+    // Accuracy on every code: what the firmware computed per sample before, against the LUT
+    float worst = 0, worst_margin = 0;
+    int worst_raw = -1;
+    for (int raw = 0; raw < 4096; raw++){
+        float formula = read_distance(ADC_raw_to_voltage(raw));
+        if (!GP2Y0A41SK0F_code_valid(raw) || formula < RANGE_MIN_CM || formula > MARGIN_MAX_CM){
+            continue;
+        }
+        float error = fabsf(GP2Y0A41SK0F_raw_to_distance(raw) - formula);
+        if (formula > RANGE_MAX_CM){
+            worst_margin = fmaxf(worst_margin, error);
+        }
+        else if (error > worst){
+            worst = error;
+            worst_raw = raw;
+        }
+    }
+
+    const double samples = (double) PASSES * count;
+    printf("%u valid codes, %d passes, bursts of %d\n\n", (unsigned) count, PASSES, BURST);
+    printf("%-34s %10s\n", "", "ns/sample");
+    printf("%-34s %10.2f\n", "formula, atof per sample", t_old * 1e9 / samples);
+    printf("%-34s %10.2f\n", "formula, constants parsed once", t_parsed * 1e9 / samples);
+    printf("%-34s %10.2f\n", "LUT", t_lut * 1e9 / samples);
+    printf("%-34s %10.2f\n", "burst, distance per code", t_burst_old * 1e9 / (PASSES * bursts * BURST));
+    printf("%-34s %10.2f\n", "burst, mean code and one lookup", t_burst_lut * 1e9 / (PASSES * bursts * BURST));
+    printf("\nLUT against the formula, %.0f to %.0f cm: max %.4f cm at code %d\n",
+           RANGE_MIN_CM, RANGE_MAX_CM, worst, worst_raw);
+    printf("LUT against the formula, %.0f to %.0f cm: max %.4f cm\n", RANGE_MAX_CM, MARGIN_MAX_CM, worst_margin);
+
+    if (worst > MAX_ERROR_CM){
+        printf("FAIL: over %.2f cm\n", MAX_ERROR_CM);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+#include "esp_adc/adc_oneshot.h"
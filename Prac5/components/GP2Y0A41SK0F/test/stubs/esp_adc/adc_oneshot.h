@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_err.h"
+
+typedef int adc_channel_t;
+typedef struct adc_oneshot_unit_ctx_t *adc_oneshot_unit_handle_t;
@@ -0,0 +1,12 @@
+// Host build stand-ins for the ESP-IDF headers GP2Y0A41SK0F.h pulls in: types only
+#pragma once
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+#define ESP_ERR_INVALID_ARG         0x102
+#define ESP_ERR_INVALID_STATE       0x103
+#define ESP_ERR_INVALID_RESPONSE    0x108
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "esp_err.h"
+
+typedef const char *esp_event_base_t;
+typedef void *esp_event_loop_handle_t;
+
+#define ESP_EVENT_DECLARE_BASE(id) extern esp_event_base_t const id
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+# Writes the synthetic traces next to this script. Recorded ones, printed by
+# CONFIG_GP2_TRACE_LOG with an "@ <cm>" line added from a ruler, go alongside.
+import os
+import random
+
+A, B, C = 11.91, 2.86, -0.109       # CONFIG_EQU_* defaults
+FULL_SCALE = 3.1                    # volts at code 4095, uncalibrated table
+N = 20                              # CONFIG_CONS_N
+BURSTS = 8
+
+
+def code(d):
+    return (A / (d + B) + C) / FULL_SCALE * 4095
+
+
+def burst(rng, d, sigma, spike=0.0, dropout=0.0):
+    # Exact counts, so a trace stays on its side of CONFIG_GP2_MIN_VALID_PERCENT
+    kinds = ["drop"] * round(N * dropout) + ["spike"] * round(N * spike)
+    kinds += ["noise"] * (N - len(kinds))
+    rng.shuffle(kinds)
+
+    out = []
+    for kind in kinds:
+        if kind == "drop":
+            c = rng.randint(0, 4)               # reads as 0 V, outside the window
+        elif kind == "spike":
+            c = code(d) + rng.choice((-1, 1)) * rng.uniform(150, 400)
+        else:
+            c = rng.gauss(code(d), sigma)
+        out.append(min(4095, max(0, round(c))))
+    return out
+
+
+def write(name, header, groups):
+    with open(os.path.join(os.path.dirname(os.path.abspath(__file__)), name), "w") as f:
+        f.write("# Synthetic, generated by make_traces.py: %s\n" % header)
+        for truth, bursts in groups:
+            f.write("@ %s\n" % truth)
+            for b in bursts:
+                f.write("0: %s\n" % " ".join(map(str, b)))
+
+
+rng = random.Random(49)
+
+write("clean.txt", "gaussian noise of 4 codes",
+      [(d, [burst(rng, d, 4) for _ in range(BURSTS)]) for d in (4, 6, 10, 15, 20, 25, 30)])
+
+write("spikes.txt", "15% of the codes hit by +-150 to 400 code spikes, as the LED pulse ripple does",
+      [(d, [burst(rng, d, 4, spike=0.15) for _ in range(BURSTS)]) for d in (6, 10, 25, 30)])
+
+write("dropouts.txt", "30% of the codes read 0 V, the window still holds enough",
+      [(d, [burst(rng, d, 4, dropout=0.3) for _ in range(BURSTS)]) for d in (8, 15, 28)])
+
+write("no_target.txt", "mostly 0 V reads, every window must be flagged",
+      [("-", [burst(rng, 20, 4, dropout=0.7) for _ in range(BURSTS)]
+             + [[0] * N for _ in range(2)])])
@@ -14,15 +14,21 @@ void Prac5_run_event(void* handler_arg, esp_event_base_t event_base, int32_t eve
 
     switch (event_id) {
         case DATA_READY:
-            QueueHandle_t distance_queue = get_distance_handle();
-            float distance;
-            if (xQueueReceive(distance_queue, &distance, pdMS_TO_TICKS(10)) == pdPASS){
-                ESP_LOGI(TAG, "measured distance %f", distance);
+        case DISTANCE_CHANGED:
+            GP2Y0A41SK0F_sample_t *sample = (GP2Y0A41SK0F_sample_t *) event_data;
+            if (sample->quality.ok){
+                ESP_LOGI(TAG, "sensor %u measured distance %f", sample->sensor, sample->distance);
             }
             else{
-                ESP_LOGI(TAG, "queue empty");
+                ESP_LOGI(TAG, "sensor %u no valid reading (%u valid codes)", sample->sensor, sample->quality.valid);
             }
             break;
+        case DISTANCE_NEAR:
+            ESP_LOGI(TAG, "sensor %u: something under %d mm", ((GP2Y0A41SK0F_sample_t *) event_data)->sensor, CONFIG_GP2_NEAR_MM);
+            break;
+        case DISTANCE_FAR:
+            ESP_LOGI(TAG, "sensor %u: clear again", ((GP2Y0A41SK0F_sample_t *) event_data)->sensor);
+            break;
         default:
             ESP_LOGI(TAG, "unknown event");
             break;
@@ -54,12 +60,14 @@ void app_main(void){
 
     adc_oneshot_unit_handle_t adc_handle = GP2Y0A41SK0F_init();
 
-    GP2Y0A41SK0F_start(adc_handle, PR5_loop);
+    GP2Y0A41SK0F_handle_t gp2;
+    ESP_ERROR_CHECK(GP2Y0A41SK0F_create(adc_handle, PR5_loop, &gp2));
+    ESP_ERROR_CHECK(GP2Y0A41SK0F_start(gp2));
 
     while(1){
         vTaskDelay(1000);
     }
 
-    GP2Y0A41SK0F_stop();
+    GP2Y0A41SK0F_destroy(gp2);
 
 }
\ No newline at end of file
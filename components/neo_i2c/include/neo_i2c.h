@@ -0,0 +1,58 @@
+#pragma once
+
+#include "driver/i2c_master.h"
+
+#define NEO_I2C_MAX_DEVICES  8  // por bus
+
+typedef struct neo_i2c_dev *neo_i2c_dev_handle_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t errors;            // cualquier resultado distinto de ESP_OK
+    uint32_t nacks;             // errores en los que el dispositivo no respondio
+    uint64_t total_latency_us;  // espera en la cola + transferencia
+    uint64_t busy_us;           // solo transferencia
+    uint32_t max_latency_us;
+} neo_i2c_stats_t;
+
+typedef struct {
+    int64_t start_us;
+    uint32_t duration_us;       // solo la transferencia, sin la espera en la cola
+    uint16_t addr;
+    uint16_t bytes;             // escritos + leidos
+    esp_err_t result;
+} neo_i2c_trace_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    float utilization;          // % del intervalo trazado que el bus estuvo con este dispositivo
+    float nack_rate;            // % de transacciones sin ACK
+} neo_i2c_trace_summary_t;
+
+// Bus en I2C_NUM_0; la primera llamada lo crea y las siguientes devuelven el mismo
+i2c_master_bus_handle_t  i2c_init(int I2C_SCL, int I2C_SDA);
+
+esp_err_t neo_i2c_bus_get(i2c_port_num_t port, int scl, int sda, i2c_master_bus_handle_t *bus);
+esp_err_t neo_i2c_bus_release(i2c_master_bus_handle_t bus);
+
+esp_err_t neo_i2c_add_device(i2c_master_bus_handle_t bus, const char *name, uint16_t addr,
+                             uint32_t scl_speed_hz, neo_i2c_dev_handle_t *dev);
+esp_err_t neo_i2c_remove_device(neo_i2c_dev_handle_t dev);
+
+// Encolan la transaccion en la tarea del bus y esperan a que termine
+esp_err_t neo_i2c_transmit(neo_i2c_dev_handle_t dev, const uint8_t *tx, size_t tx_len, int timeout_ms);
+esp_err_t neo_i2c_receive(neo_i2c_dev_handle_t dev, uint8_t *rx, size_t rx_len, int timeout_ms);
+esp_err_t neo_i2c_transmit_receive(neo_i2c_dev_handle_t dev, const uint8_t *tx, size_t tx_len,
+                                   uint8_t *rx, size_t rx_len, int timeout_ms);
+
+esp_err_t neo_i2c_get_stats(neo_i2c_dev_handle_t dev, neo_i2c_stats_t *stats);
+void neo_i2c_log_stats(i2c_master_bus_handle_t bus);
+
+// Requieren CONFIG_NEO_I2C_TRACE, si no devuelven ESP_ERR_NOT_SUPPORTED
+esp_err_t neo_i2c_trace_summary(neo_i2c_dev_handle_t dev, neo_i2c_trace_summary_t *summary);
+esp_err_t neo_i2c_trace_read(i2c_master_bus_handle_t bus, neo_i2c_trace_t *records, size_t max_records, size_t *count);
+esp_err_t neo_i2c_trace_clear(i2c_master_bus_handle_t bus);
+void neo_i2c_trace_log(i2c_master_bus_handle_t bus);
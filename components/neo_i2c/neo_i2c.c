@@ -0,0 +1,543 @@
+#include <string.h>
+#include <stdlib.h>
+#include "neo_i2c.h"
+#include "driver/i2c_master.h"
+#include "driver/i2c_slave.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "sdkconfig.h"
+
+// Segun la version de IDF un NACK se devuelve como INVALID_STATE o INVALID_RESPONSE
+#define IS_NACK(err) ((err) == ESP_ERR_INVALID_STATE || (err) == ESP_ERR_INVALID_RESPONSE)
+
+static const char *TAG = "i2c_driver";
+
+struct neo_i2c_dev {
+    struct neo_i2c_bus *bus;
+    i2c_master_dev_handle_t handle;
+    const char *name;
+    uint16_t addr;
+    SemaphoreHandle_t lock;     // una transaccion en vuelo por dispositivo
+    SemaphoreHandle_t done;
+    neo_i2c_stats_t stats;
+};
+
+struct neo_i2c_bus {
+    i2c_master_bus_handle_t handle;
+    int scl;
+    int sda;
+    int users;
+    QueueHandle_t queue;
+    TaskHandle_t worker;
+    SemaphoreHandle_t worker_done;
+    SemaphoreHandle_t registry_lock;
+    portMUX_TYPE stats_lock;
+    struct neo_i2c_dev devices[NEO_I2C_MAX_DEVICES];
+#if CONFIG_NEO_I2C_TRACE
+    neo_i2c_trace_t trace[CONFIG_NEO_I2C_TRACE_DEPTH];
+    size_t trace_head;          // siguiente posicion a escribir
+    size_t trace_count;
+    uint32_t trace_seq;         // registros escritos desde el arranque, no lo toca el clear
+#endif
+};
+
+typedef struct {
+    struct neo_i2c_dev *dev;    // NULL para parar la tarea del bus
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+    int timeout_ms;
+    int64_t queued_us;
+    esp_err_t *result;
+} neo_i2c_txn_t;
+
+static struct neo_i2c_bus buses[I2C_NUM_MAX];
+static portMUX_TYPE buses_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static struct neo_i2c_bus *find_bus(i2c_master_bus_handle_t handle)
+{
+    for (int i = 0; i < I2C_NUM_MAX; i++) {
+        if (buses[i].handle != NULL && buses[i].handle == handle) {
+            return &buses[i];
+        }
+    }
+    return NULL;
+}
+
+static void bus_task(void *arg)
+{
+    struct neo_i2c_bus *bus = (struct neo_i2c_bus *) arg;
+    neo_i2c_txn_t txn;
+
+    while (xQueueReceive(bus->queue, &txn, portMAX_DELAY) == pdPASS) {
+        if (txn.dev == NULL) {
+            break;
+        }
+
+        esp_err_t ret;
+        int64_t start = esp_timer_get_time();
+        if (txn.tx_len > 0 && txn.rx_len > 0) {
+            ret = i2c_master_transmit_receive(txn.dev->handle, txn.tx, txn.tx_len, txn.rx, txn.rx_len, txn.timeout_ms);
+        } else if (txn.rx_len > 0) {
+            ret = i2c_master_receive(txn.dev->handle, txn.rx, txn.rx_len, txn.timeout_ms);
+        } else {
+            ret = i2c_master_transmit(txn.dev->handle, txn.tx, txn.tx_len, txn.timeout_ms);
+        }
+        int64_t end = esp_timer_get_time();
+        uint32_t latency = (uint32_t) (end - txn.queued_us);
+
+        neo_i2c_stats_t *stats = &txn.dev->stats;
+        portENTER_CRITICAL(&bus->stats_lock);
+        stats->transactions++;
+        stats->total_latency_us += latency;
+        stats->busy_us += end - start;
+        if (latency > stats->max_latency_us) {
+            stats->max_latency_us = latency;
+        }
+        if (ret != ESP_OK) {
+            stats->errors++;
+            if (IS_NACK(ret)) {
+                stats->nacks++;
+            }
+        }
+#if CONFIG_NEO_I2C_TRACE
+        bus->trace[bus->trace_head] = (neo_i2c_trace_t) {
+            .start_us = start,
+            .duration_us = (uint32_t) (end - start),
+            .addr = txn.dev->addr,
+            .bytes = (uint16_t) (txn.tx_len + txn.rx_len),
+            .result = ret,
+        };
+        bus->trace_head = (bus->trace_head + 1) % CONFIG_NEO_I2C_TRACE_DEPTH;
+        bus->trace_seq++;
+        if (bus->trace_count < CONFIG_NEO_I2C_TRACE_DEPTH) {
+            bus->trace_count++;
+        }
+#endif
+        portEXIT_CRITICAL(&bus->stats_lock);
+
+        *txn.result = ret;
+        xSemaphoreGive(txn.dev->done);
+    }
+
+    xSemaphoreGive(bus->worker_done);
+    vTaskDelete(NULL);
+}
+
+static void bus_free(struct neo_i2c_bus *bus)
+{
+    if (bus->queue) vQueueDelete(bus->queue);
+    if (bus->worker_done) vSemaphoreDelete(bus->worker_done);
+    if (bus->registry_lock) vSemaphoreDelete(bus->registry_lock);
+    if (bus->handle) i2c_del_master_bus(bus->handle);
+    memset(bus, 0, sizeof(*bus));
+}
+
+esp_err_t neo_i2c_bus_get(i2c_port_num_t port, int scl, int sda, i2c_master_bus_handle_t *bus_ret)
+{
+    if (port < 0 || port >= I2C_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct neo_i2c_bus *bus = &buses[port];
+
+    portENTER_CRITICAL(&buses_lock);
+    if (bus->handle != NULL || bus->users < 0) {
+        bool same_pins = bus->handle != NULL && bus->scl == scl && bus->sda == sda;
+        if (same_pins) {
+            bus->users++;
+        }
+        portEXIT_CRITICAL(&buses_lock);
+
+        if (!same_pins) {
+            ESP_LOGE(TAG, "I2C port %d busy or in use with other pins", (int) port);
+            return ESP_ERR_INVALID_STATE;
+        }
+        ESP_LOGW(TAG, "I2C already initialized");
+        *bus_ret = bus->handle;
+        return ESP_OK;
+    }
+    bus->users = -1;  // reservado mientras se crea
+    portEXIT_CRITICAL(&buses_lock);
+
+    i2c_master_bus_config_t bus_config = {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .i2c_port = port,
+        .scl_io_num = scl,
+        .sda_io_num = sda,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+
+    i2c_master_bus_handle_t handle = NULL;
+    esp_err_t ret = i2c_new_master_bus(&bus_config, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "I2C bus creation failed: %s", esp_err_to_name(ret));
+        bus->users = 0;
+        return ret;
+    }
+
+    bus->scl = scl;
+    bus->sda = sda;
+    bus->stats_lock = (portMUX_TYPE) portMUX_INITIALIZER_UNLOCKED;
+    bus->queue = xQueueCreate(CONFIG_NEO_I2C_QUEUE_LEN, sizeof(neo_i2c_txn_t));
+    bus->worker_done = xSemaphoreCreateBinary();
+    bus->registry_lock = xSemaphoreCreateMutex();
+    if (bus->queue == NULL || bus->worker_done == NULL || bus->registry_lock == NULL ||
+        xTaskCreate(bus_task, "neo_i2c", 3072, bus, CONFIG_NEO_I2C_TASK_PRIORITY, &bus->worker) != pdPASS) {
+        bus->handle = handle;
+        bus_free(bus);
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&buses_lock);
+    bus->handle = handle;
+    bus->users = 1;
+    portEXIT_CRITICAL(&buses_lock);
+
+    ESP_LOGI(TAG, "I2C initialized successfully");
+    *bus_ret = handle;
+    return ESP_OK;
+}
+
+i2c_master_bus_handle_t  i2c_init(int I2C_SCL, int I2C_SDA){
+
+    i2c_master_bus_handle_t i2c_handle = NULL;
+
+    ESP_ERROR_CHECK(neo_i2c_bus_get(I2C_NUM_0, I2C_SCL, I2C_SDA, &i2c_handle));
+
+    return i2c_handle;
+}
+
+esp_err_t neo_i2c_bus_release(i2c_master_bus_handle_t handle)
+{
+    struct neo_i2c_bus *bus = find_bus(handle);
+    if (bus == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    portENTER_CRITICAL(&buses_lock);
+    bool last = --bus->users == 0;
+    portEXIT_CRITICAL(&buses_lock);
+    if (!last) {
+        return ESP_OK;
+    }
+
+    neo_i2c_txn_t stop = { .dev = NULL };
+    xQueueSend(bus->queue, &stop, portMAX_DELAY);
+    xSemaphoreTake(bus->worker_done, portMAX_DELAY);
+
+    for (int i = 0; i < NEO_I2C_MAX_DEVICES; i++) {
+        if (bus->devices[i].handle != NULL) {
+            neo_i2c_remove_device(&bus->devices[i]);
+        }
+    }
+
+    bus_free(bus);
+    ESP_LOGI(TAG, "I2C bus released");
+    return ESP_OK;
+}
+
+esp_err_t neo_i2c_add_device(i2c_master_bus_handle_t handle, const char *name, uint16_t addr,
+                             uint32_t scl_speed_hz, neo_i2c_dev_handle_t *dev_ret)
+{
+    struct neo_i2c_bus *bus = find_bus(handle);
+    if (bus == NULL) {
+        ESP_LOGE(TAG, "Bus not created with neo_i2c_bus_get()");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    xSemaphoreTake(bus->registry_lock, portMAX_DELAY);
+
+    for (int i = 0; i < NEO_I2C_MAX_DEVICES; i++) {
+        struct neo_i2c_dev *dev = &bus->devices[i];
+        if (dev->handle != NULL) {
+            continue;
+        }
+
+        i2c_device_config_t dev_config = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = addr,
+            .scl_speed_hz = scl_speed_hz,
+        };
+
+        dev->lock = xSemaphoreCreateMutex();
+        dev->done = xSemaphoreCreateBinary();
+        if (dev->lock == NULL || dev->done == NULL) {
+            ret = ESP_ERR_NO_MEM;
+        } else {
+            ret = i2c_master_bus_add_device(bus->handle, &dev_config, &dev->handle);
+        }
+        if (ret != ESP_OK) {
+            if (dev->lock) vSemaphoreDelete(dev->lock);
+            if (dev->done) vSemaphoreDelete(dev->done);
+            memset(dev, 0, sizeof(*dev));
+            break;
+        }
+
+        dev->bus = bus;
+        dev->name = name;
+        dev->addr = addr;
+        memset(&dev->stats, 0, sizeof(dev->stats));
+        *dev_ret = dev;
+        ESP_LOGI(TAG, "%s registered at 0x%02X, %lu Hz", name, addr, (unsigned long) scl_speed_hz);
+        break;
+    }
+
+    xSemaphoreGive(bus->registry_lock);
+    return ret;
+}
+
+esp_err_t neo_i2c_remove_device(neo_i2c_dev_handle_t dev)
+{
+    struct neo_i2c_bus *bus = dev->bus;
+
+    xSemaphoreTake(bus->registry_lock, portMAX_DELAY);
+    xSemaphoreTake(dev->lock, portMAX_DELAY);  // espera a la transaccion en curso
+
+    esp_err_t ret = i2c_master_bus_rm_device(dev->handle);
+    vSemaphoreDelete(dev->done);
+    vSemaphoreDelete(dev->lock);
+    memset(dev, 0, sizeof(*dev));
+
+    xSemaphoreGive(bus->registry_lock);
+    return ret;
+}
+
+static esp_err_t neo_i2c_submit(neo_i2c_dev_handle_t dev, const uint8_t *tx, size_t tx_len,
+                                uint8_t *rx, size_t rx_len, int timeout_ms)
+{
+    esp_err_t result = ESP_FAIL;
+    neo_i2c_txn_t txn = {
+        .dev = dev,
+        .tx = tx,
+        .tx_len = tx_len,
+        .rx = rx,
+        .rx_len = rx_len,
+        .timeout_ms = timeout_ms,
+        .result = &result,
+    };
+
+    xSemaphoreTake(dev->lock, portMAX_DELAY);
+    txn.queued_us = esp_timer_get_time();
+    xQueueSend(dev->bus->queue, &txn, portMAX_DELAY);
+    xSemaphoreTake(dev->done, portMAX_DELAY);
+    xSemaphoreGive(dev->lock);
+
+    return result;
+}
+
+esp_err_t neo_i2c_transmit(neo_i2c_dev_handle_t dev, const uint8_t *tx, size_t tx_len, int timeout_ms)
+{
+    return neo_i2c_submit(dev, tx, tx_len, NULL, 0, timeout_ms);
+}
+
+esp_err_t neo_i2c_receive(neo_i2c_dev_handle_t dev, uint8_t *rx, size_t rx_len, int timeout_ms)
+{
+    return neo_i2c_submit(dev, NULL, 0, rx, rx_len, timeout_ms);
+}
+
+esp_err_t neo_i2c_transmit_receive(neo_i2c_dev_handle_t dev, const uint8_t *tx, size_t tx_len,
+                                   uint8_t *rx, size_t rx_len, int timeout_ms)
+{
+    return neo_i2c_submit(dev, tx, tx_len, rx, rx_len, timeout_ms);
+}
+
+esp_err_t neo_i2c_get_stats(neo_i2c_dev_handle_t dev, neo_i2c_stats_t *stats)
+{
+    portENTER_CRITICAL(&dev->bus->stats_lock);
+    *stats = dev->stats;
+    portEXIT_CRITICAL(&dev->bus->stats_lock);
+    return ESP_OK;
+}
+
+void neo_i2c_log_stats(i2c_master_bus_handle_t handle)
+{
+    struct neo_i2c_bus *bus = find_bus(handle);
+    if (bus == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < NEO_I2C_MAX_DEVICES; i++) {
+        struct neo_i2c_dev *dev = &bus->devices[i];
+        if (dev->handle == NULL) {
+            continue;
+        }
+
+        neo_i2c_stats_t stats;
+        neo_i2c_get_stats(dev, &stats);
+        ESP_LOGI(TAG, "%s (0x%02X): %lu txn, %lu errors (%lu NACK), avg %lu us, max %lu us",
+                 dev->name, dev->addr,
+                 (unsigned long) stats.transactions, (unsigned long) stats.errors, (unsigned long) stats.nacks,
+                 (unsigned long) (stats.transactions ? stats.total_latency_us / stats.transactions : 0),
+                 (unsigned long) stats.max_latency_us);
+    }
+}
+
+#if CONFIG_NEO_I2C_TRACE
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+// Registros copiados por cada entrada a la seccion critica
+#define TRACE_COPY_CHUNK 8
+
+// Copia los registros del mas antiguo al mas reciente, por tramos para no dejar las interrupciones
+// bloqueadas durante toda la copia. Si la tarea del bus pisa un registro aun no copiado, lo copiado
+// hasta ahi se descarta y la copia sigue desde el mas antiguo que queda, asi no hay huecos
+static size_t trace_snapshot(struct neo_i2c_bus *bus, neo_i2c_trace_t *records, size_t max_records)
+{
+    portENTER_CRITICAL(&bus->stats_lock);
+    size_t count = bus->trace_count < max_records ? bus->trace_count : max_records;
+    const uint32_t end = bus->trace_seq;
+    portEXIT_CRITICAL(&bus->stats_lock);
+
+    uint32_t seq = end - count;
+    size_t n = 0;
+    while (seq != end) {
+        portENTER_CRITICAL(&bus->stats_lock);
+        uint32_t behind = bus->trace_seq - seq;
+        if (behind > CONFIG_NEO_I2C_TRACE_DEPTH) {
+            n = 0;
+            behind = bus->trace_seq - end < CONFIG_NEO_I2C_TRACE_DEPTH ? CONFIG_NEO_I2C_TRACE_DEPTH : bus->trace_seq - end;
+            seq = bus->trace_seq - behind;
+        }
+        size_t pos = (bus->trace_head + CONFIG_NEO_I2C_TRACE_DEPTH - behind) % CONFIG_NEO_I2C_TRACE_DEPTH;
+        for (size_t i = 0; i < TRACE_COPY_CHUNK && seq != end; i++, seq++) {
+            records[n++] = bus->trace[pos];
+            pos = (pos + 1) % CONFIG_NEO_I2C_TRACE_DEPTH;
+        }
+        portEXIT_CRITICAL(&bus->stats_lock);
+    }
+    return n;
+}
+
+esp_err_t neo_i2c_trace_read(i2c_master_bus_handle_t handle, neo_i2c_trace_t *records, size_t max_records, size_t *count)
+{
+    struct neo_i2c_bus *bus = find_bus(handle);
+    if (bus == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    *count = trace_snapshot(bus, records, max_records);
+    return ESP_OK;
+}
+
+esp_err_t neo_i2c_trace_clear(i2c_master_bus_handle_t handle)
+{
+    struct neo_i2c_bus *bus = find_bus(handle);
+    if (bus == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // La cabeza no se mueve: una copia en curso sigue situando sus registros por trace_seq
+    portENTER_CRITICAL(&bus->stats_lock);
+    bus->trace_count = 0;
+    portEXIT_CRITICAL(&bus->stats_lock);
+    return ESP_OK;
+}
+
+esp_err_t neo_i2c_trace_summary(neo_i2c_dev_handle_t dev, neo_i2c_trace_summary_t *summary)
+{
+    neo_i2c_trace_t *records = malloc(CONFIG_NEO_I2C_TRACE_DEPTH * sizeof(neo_i2c_trace_t));
+    uint32_t *durations = malloc(CONFIG_NEO_I2C_TRACE_DEPTH * sizeof(uint32_t));
+    if (records == NULL || durations == NULL) {
+        free(records);
+        free(durations);
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t count = trace_snapshot(dev->bus, records, CONFIG_NEO_I2C_TRACE_DEPTH);
+    int64_t window_start = count ? records[0].start_us : 0;
+    int64_t window_us = count ? esp_timer_get_time() - window_start : 0;
+
+    uint64_t busy_us = 0;
+    uint32_t nacks = 0;
+    size_t n = 0;
+
+    *summary = (neo_i2c_trace_summary_t) {0};
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].addr != dev->addr) {
+            continue;
+        }
+        durations[n++] = records[i].duration_us;
+        busy_us += records[i].duration_us;
+        summary->bytes += records[i].bytes;
+        if (IS_NACK(records[i].result)) {
+            nacks++;
+        }
+    }
+
+    if (n > 0) {
+        qsort(durations, n, sizeof(uint32_t), cmp_u32);
+        summary->transactions = n;
+        summary->p50_us = durations[(n - 1) * 50 / 100];
+        summary->p99_us = durations[(n - 1) * 99 / 100];
+        summary->nack_rate = 100.0f * nacks / n;
+        summary->utilization = window_us > 0 ? 100.0f * busy_us / window_us : 0.0f;
+    }
+
+    free(records);
+    free(durations);
+    return ESP_OK;
+}
+
+void neo_i2c_trace_log(i2c_master_bus_handle_t handle)
+{
+    struct neo_i2c_bus *bus = find_bus(handle);
+    if (bus == NULL) {
+        return;
+    }
+
+    float total = 0.0f;
+    for (int i = 0; i < NEO_I2C_MAX_DEVICES; i++) {
+        struct neo_i2c_dev *dev = &bus->devices[i];
+        neo_i2c_trace_summary_t summary;
+        if (dev->handle == NULL || neo_i2c_trace_summary(dev, &summary) != ESP_OK) {
+            continue;
+        }
+
+        total += summary.utilization;
+        ESP_LOGI(TAG, "%s (0x%02X): %lu txn, %lu bytes, bus %.2f %%, p50 %lu us, p99 %lu us, NACK %.1f %%",
+                 dev->name, dev->addr, (unsigned long) summary.transactions, (unsigned long) summary.bytes,
+                 summary.utilization, (unsigned long) summary.p50_us, (unsigned long) summary.p99_us,
+                 summary.nack_rate);
+    }
+    ESP_LOGI(TAG, "bus utilization %.2f %%", total);
+}
+
+#else
+
+esp_err_t neo_i2c_trace_read(i2c_master_bus_handle_t handle, neo_i2c_trace_t *records, size_t max_records, size_t *count)
+{
+    *count = 0;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t neo_i2c_trace_clear(i2c_master_bus_handle_t handle)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t neo_i2c_trace_summary(neo_i2c_dev_handle_t dev, neo_i2c_trace_summary_t *summary)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void neo_i2c_trace_log(i2c_master_bus_handle_t handle)
+{
+}
+
+#endif
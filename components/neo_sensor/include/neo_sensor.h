@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NEO_SENSOR_MAX_SAMPLES  4   /*!< Max records a single fetch() may produce */
+
+typedef enum {
+    NEO_SAMPLE_TEMPERATURE = 0,  /*!< value[0] in degrees Celsius */
+    NEO_SAMPLE_HUMIDITY,         /*!< value[0] in %RH */
+    NEO_SAMPLE_ACCEL,            /*!< value[0..2] x, y, z in g */
+    NEO_SAMPLE_GYRO,             /*!< value[0..2] x, y, z in degrees per second */
+    NEO_SAMPLE_DISTANCE,         /*!< value[0] in cm */
+} neo_sample_kind_t;
+
+/**
+ * @brief Timestamped measurement shared by every sensor (24 bytes)
+ */
+typedef struct {
+    int64_t timestamp_us;   /*!< esp_timer_get_time() of the measurement, fetch time if the driver leaves it 0 */
+    uint8_t sensor_id;      /*!< neo_sensor_t::id of the producer */
+    uint8_t kind;           /*!< neo_sample_kind_t */
+    uint8_t flags;          /*!< Sensor specific flags, 0 if unused */
+    uint8_t reserved;
+    float value[3];         /*!< Unused components are 0 */
+} neo_sample_t;
+
+typedef struct neo_sensor neo_sensor_t;
+
+/**
+ * @brief Operations implemented by each driver adapter. Any of them but fetch may be NULL.
+ */
+typedef struct {
+    esp_err_t (*init)(neo_sensor_t *sensor);   /*!< Bring the device to a ready state */
+    esp_err_t (*start)(neo_sensor_t *sensor);  /*!< Trigger a conversion */
+    esp_err_t (*fetch)(neo_sensor_t *sensor, neo_sample_t *samples, size_t max_samples, size_t *count);
+                                               /*!< Read the result, at least conversion_us after start */
+    esp_err_t (*sleep)(neo_sensor_t *sensor);  /*!< Put the device in its lowest power state */
+} neo_sensor_ops_t;
+
+struct neo_sensor {
+    const neo_sensor_ops_t *ops;
+    const char *name;
+    void *ctx;               /*!< Driver object the adapter works on */
+    uint32_t conversion_us;  /*!< Worst case time between start() and fetch() */
+    uint8_t id;              /*!< Stamped on every sample produced by this sensor */
+};
+
+/**
+ * @brief Call the init operation of the sensor, if any
+ */
+esp_err_t neo_sensor_init(neo_sensor_t *sensor);
+
+/**
+ * @brief Call the start operation of the sensor, if any
+ */
+esp_err_t neo_sensor_start(neo_sensor_t *sensor);
+
+/**
+ * @brief Fetch the samples of the last conversion
+ *
+ * The returned records carry the sensor id, and the fetch time unless the driver
+ * already timestamped them.
+ *
+ * @param sensor sensor to read
+ * @param samples buffer for the records, at least NEO_SENSOR_MAX_SAMPLES long
+ * @param max_samples length of samples
+ * @param count number of records written
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Missing fetch operation
+ *     - Others Error reported by the driver, no records are written
+ */
+esp_err_t neo_sensor_fetch(neo_sensor_t *sensor, neo_sample_t *samples, size_t max_samples, size_t *count);
+
+/**
+ * @brief Call the sleep operation of the sensor, if any
+ */
+esp_err_t neo_sensor_sleep(neo_sensor_t *sensor);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "neo_sensor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NEO_SCHED_MAX_SENSORS   8
+
+/**
+ * @brief Receives every sample fetched in one scheduler pass, from the scheduler task
+ */
+typedef void (*neo_sched_sink_t)(const neo_sample_t *samples, size_t count, void *arg);
+
+typedef struct {
+    neo_sched_sink_t sink;      /*!< Consumer of the samples */
+    void *sink_arg;             /*!< Passed to sink */
+    uint32_t jitter_ms;         /*!< Starts may run this much early and fetches this much late to share a wake-up */
+    uint32_t task_stack_size;   /*!< 0 selects 4096 */
+    UBaseType_t task_priority;  /*!< 0 selects 5 */
+} neo_sched_config_t;
+
+typedef struct {
+    uint32_t samples;           /*!< Successful fetches */
+    uint32_t errors;            /*!< Failed start or fetch */
+    uint32_t overruns;          /*!< Periods skipped because the scheduler was late */
+} neo_sched_stats_t;
+
+typedef struct neo_sched *neo_sched_handle_t;
+
+/**
+ * @brief Create a scheduler. Sensors are added with neo_sched_add() before neo_sched_start().
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Missing sink
+ *     - ESP_ERR_NO_MEM Not enough memory
+ */
+esp_err_t neo_sched_create(const neo_sched_config_t *config, neo_sched_handle_t *handle_ret);
+
+/**
+ * @brief Initialize a sensor and sample it every period_ms
+ *
+ * The sensor is started period_ms apart and fetched conversion_us after each start.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_STATE Scheduler already running
+ *     - ESP_ERR_NO_MEM NEO_SCHED_MAX_SENSORS reached
+ *     - Others Error from the sensor init operation
+ */
+esp_err_t neo_sched_add(neo_sched_handle_t sched, neo_sensor_t *sensor, uint32_t period_ms);
+
+/**
+ * @brief Start the scheduler task. Every sensor is started on the first pass.
+ */
+esp_err_t neo_sched_start(neo_sched_handle_t sched);
+
+/**
+ * @brief Counters of a sensor added to the scheduler
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_NOT_FOUND Sensor not in the scheduler
+ */
+esp_err_t neo_sched_get_stats(neo_sched_handle_t sched, const neo_sensor_t *sensor, neo_sched_stats_t *stats);
+
+/**
+ * @brief Stop the scheduler task, put every sensor to sleep and free the scheduler
+ */
+void neo_sched_delete(neo_sched_handle_t sched);
+
+#ifdef __cplusplus
+}
+#endif
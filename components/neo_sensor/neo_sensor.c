@@ -0,0 +1,53 @@
+#include "neo_sensor.h"
+
+#include "esp_timer.h"
+
+esp_err_t neo_sensor_init(neo_sensor_t *sensor)
+{
+    if (sensor->ops->init == NULL) {
+        return ESP_OK;
+    }
+    return sensor->ops->init(sensor);
+}
+
+esp_err_t neo_sensor_start(neo_sensor_t *sensor)
+{
+    if (sensor->ops->start == NULL) {
+        return ESP_OK;
+    }
+    return sensor->ops->start(sensor);
+}
+
+esp_err_t neo_sensor_fetch(neo_sensor_t *sensor, neo_sample_t *samples, size_t max_samples, size_t *count)
+{
+    *count = 0;
+
+    if (sensor->ops->fetch == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t n = 0;
+    esp_err_t ret = sensor->ops->fetch(sensor, samples, max_samples, &n);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < n; i++) {
+        if (samples[i].timestamp_us == 0) {
+            samples[i].timestamp_us = now;
+        }
+        samples[i].sensor_id = sensor->id;
+    }
+    *count = n;
+
+    return ESP_OK;
+}
+
+esp_err_t neo_sensor_sleep(neo_sensor_t *sensor)
+{
+    if (sensor->ops->sleep == NULL) {
+        return ESP_OK;
+    }
+    return sensor->ops->sleep(sensor);
+}
@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "neo_sensor_sched.h"
+
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#define FETCH_RETRIES   1   // one extra tick for a device that still NACKs
+
+static const char *TAG = "neo_sched";
+
+typedef enum {
+    ENTRY_IDLE,
+    ENTRY_CONVERTING,
+} entry_state_t;
+
+typedef struct {
+    neo_sensor_t *sensor;
+    int64_t period_us;
+    int64_t next_start_us;
+    int64_t ready_us;
+    entry_state_t state;
+    uint8_t retries;
+    neo_sched_stats_t stats;
+} sched_entry_t;
+
+struct neo_sched {
+    neo_sched_config_t config;
+    sched_entry_t entries[NEO_SCHED_MAX_SENSORS];
+    size_t num_entries;
+    TaskHandle_t task;
+    SemaphoreHandle_t done;
+    volatile bool stop;
+};
+
+esp_err_t neo_sched_create(const neo_sched_config_t *config, neo_sched_handle_t *handle_ret)
+{
+    if (config == NULL || config->sink == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct neo_sched *sched = calloc(1, sizeof(struct neo_sched));
+    if (sched == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    sched->done = xSemaphoreCreateBinary();
+    if (sched->done == NULL) {
+        free(sched);
+        return ESP_ERR_NO_MEM;
+    }
+
+    sched->config = *config;
+    if (sched->config.task_stack_size == 0) {
+        sched->config.task_stack_size = 4096;
+    }
+    if (sched->config.task_priority == 0) {
+        sched->config.task_priority = 5;
+    }
+
+    *handle_ret = sched;
+    return ESP_OK;
+}
+
+esp_err_t neo_sched_add(neo_sched_handle_t sched, neo_sensor_t *sensor, uint32_t period_ms)
+{
+    if (sched->task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (sched->num_entries == NEO_SCHED_MAX_SENSORS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = neo_sensor_init(sensor);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%s init failed: %s", sensor->name, esp_err_to_name(ret));
+        return ret;
+    }
+
+    sched->entries[sched->num_entries++] = (sched_entry_t) {
+        .sensor = sensor,
+        .period_us = (int64_t) period_ms * 1000,
+        .state = ENTRY_IDLE,
+    };
+
+    return ESP_OK;
+}
+
+static void sched_start_due(struct neo_sched *sched, int64_t now, int64_t jitter_us)
+{
+    for (size_t i = 0; i < sched->num_entries; i++) {
+        sched_entry_t *e = &sched->entries[i];
+
+        if (e->state != ENTRY_IDLE || e->next_start_us > now + jitter_us) {
+            continue;
+        }
+
+        if (neo_sensor_start(e->sensor) == ESP_OK) {
+            e->state = ENTRY_CONVERTING;
+            e->ready_us = now + e->sensor->conversion_us;
+            e->retries = 0;
+        } else {
+            e->stats.errors++;
+        }
+
+        // Keep the phase of the period; if we are a whole period late, skip instead of bursting
+        e->next_start_us += e->period_us;
+        if (e->next_start_us <= now) {
+            e->stats.overruns++;
+            e->next_start_us = now + e->period_us;
+        }
+    }
+}
+
+static size_t sched_fetch_ready(struct neo_sched *sched, int64_t now, neo_sample_t *samples, size_t max_samples)
+{
+    size_t total = 0;
+
+    // Back to back, so every device ready at this wake-up is read in one burst on the bus
+    for (size_t i = 0; i < sched->num_entries; i++) {
+        sched_entry_t *e = &sched->entries[i];
+
+        if (e->state != ENTRY_CONVERTING || e->ready_us > now) {
+            continue;
+        }
+        if (max_samples - total < NEO_SENSOR_MAX_SAMPLES) {
+            break;  // picked up on the next pass
+        }
+
+        size_t count = 0;
+        esp_err_t ret = neo_sensor_fetch(e->sensor, &samples[total], max_samples - total, &count);
+        if (ret == ESP_OK) {
+            e->state = ENTRY_IDLE;
+            e->stats.samples++;
+            total += count;
+        } else if (e->retries < FETCH_RETRIES) {
+            e->retries++;
+            e->ready_us = now + portTICK_PERIOD_MS * 1000;
+        } else {
+            e->state = ENTRY_IDLE;
+            e->stats.errors++;
+            ESP_LOGD(TAG, "%s fetch failed: %s", e->sensor->name, esp_err_to_name(ret));
+        }
+    }
+
+    return total;
+}
+
+static int64_t sched_next_wakeup(struct neo_sched *sched, int64_t jitter_us)
+{
+    int64_t next_start = INT64_MAX;
+    int64_t next_ready = INT64_MAX;
+
+    for (size_t i = 0; i < sched->num_entries; i++) {
+        sched_entry_t *e = &sched->entries[i];
+
+        if (e->state == ENTRY_CONVERTING) {
+            if (e->ready_us < next_ready) {
+                next_ready = e->ready_us;
+            }
+        } else if (e->next_start_us - jitter_us < next_start) {
+            next_start = e->next_start_us - jitter_us;
+        }
+    }
+
+    if (next_ready <= next_start) {
+        // Delay the earliest fetch a little if that lets other conversions finish in the same wake-up
+        int64_t batch = next_ready;
+        for (size_t i = 0; i < sched->num_entries; i++) {
+            sched_entry_t *e = &sched->entries[i];
+            if (e->state == ENTRY_CONVERTING && e->ready_us <= next_ready + jitter_us && e->ready_us > batch) {
+                batch = e->ready_us;
+            }
+        }
+        return batch;
+    }
+
+    return next_start;
+}
+
+static void neo_sched_task(void *arg)
+{
+    struct neo_sched *sched = (struct neo_sched *) arg;
+    const int64_t jitter_us = (int64_t) sched->config.jitter_ms * 1000;
+    const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+    neo_sample_t samples[NEO_SCHED_MAX_SENSORS * NEO_SENSOR_MAX_SAMPLES];
+
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < sched->num_entries; i++) {
+        sched->entries[i].next_start_us = now;
+    }
+
+    while (!sched->stop) {
+        now = esp_timer_get_time();
+
+        size_t count = sched_fetch_ready(sched, now, samples, sizeof(samples) / sizeof(samples[0]));
+        sched_start_due(sched, now, jitter_us);
+
+        if (count > 0) {
+            sched->config.sink(samples, count, sched->config.sink_arg);
+        }
+
+        int64_t wakeup = sched_next_wakeup(sched, jitter_us);
+        if (wakeup == INT64_MAX) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        int64_t wait_us = wakeup - esp_timer_get_time();
+        if (wait_us > 0) {
+            // Round up: waking before the deadline would only cost another pass
+            ulTaskNotifyTake(pdTRUE, (TickType_t) ((wait_us + tick_us - 1) / tick_us));
+        }
+    }
+
+    xSemaphoreGive(sched->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t neo_sched_start(neo_sched_handle_t sched)
+{
+    if (sched->task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sched->stop = false;
+    if (xTaskCreate(neo_sched_task, "neo_sched", sched->config.task_stack_size, sched,
+                    sched->config.task_priority, &sched->task) != pdPASS) {
+        sched->task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Scheduler started with %d sensors", (int) sched->num_entries);
+    return ESP_OK;
+}
+
+esp_err_t neo_sched_get_stats(neo_sched_handle_t sched, const neo_sensor_t *sensor, neo_sched_stats_t *stats)
+{
+    for (size_t i = 0; i < sched->num_entries; i++) {
+        if (sched->entries[i].sensor == sensor) {
+            *stats = sched->entries[i].stats;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+void neo_sched_delete(neo_sched_handle_t sched)
+{
+    if (sched->task != NULL) {
+        sched->stop = true;
+        xTaskNotifyGive(sched->task);
+        xSemaphoreTake(sched->done, portMAX_DELAY);
+        sched->task = NULL;
+    }
+
+    for (size_t i = 0; i < sched->num_entries; i++) {
+        neo_sensor_sleep(sched->entries[i].sensor);
+    }
+
+    vSemaphoreDelete(sched->done);
+    free(sched);
+}
@@ -52,7 +52,7 @@ extern "C" {
 #endif
 
 #ifdef ESP32_TARGET
-#include "driver/i2c_master.h"
+#include "neo_i2c.h"
 #else
 #include "main.h"
 #endif /* ESP32_TARGET */
@@ -60,6 +60,7 @@ extern "C" {
 /* Exported Macros -----------------------------------------------------------*/
 #define SHTC3_I2C_ADDR						0x70
 #define SHTC3_I2C_BUFFER_LEN_MAX			8
+#define SHTC3_MEAS_TIME_NM_US				12100 /* max. measurement duration in normal mode */
 
 #define SHTC3_CMD_READ_ID					0xEFC8 /* command: read ID register */
 #define SHTC3_CMD_SOFT_RESET				0x805D /* soft reset */
@@ -78,7 +79,7 @@ extern "C" {
 /* Exported typedef ----------------------------------------------------------*/
 typedef struct {
 #ifdef ESP32_TARGET
-	i2c_master_dev_handle_t handle;
+	neo_i2c_dev_handle_t handle;
 #else
 	uint8_t addr;
 	I2C_HandleTypeDef *handle;
@@ -97,7 +98,7 @@ typedef struct {
  *
  * @param me         : Pointer to a shtc3_t instance
  * @param i2c_handle : Pointer to a structure with the data to initialize the
- * 					   I2C device
+ * 					   I2C device (bus from neo_i2c_bus_get() on ESP32)
  * @param dev_addr   : I2C device address
  *
  * @return ESP_OK on success
@@ -155,6 +156,32 @@ int shtc3_get_temp_and_hum_lpm(shtc3_t *const me, float *temp, float *hum);
  */
 int shtc3_get_temp_and_hum_polling(shtc3_t *const me, float *temp, float *hum);
 
+/**
+ * @brief Function to wake up the device and trigger a measurement without
+ *        clock stretching. The result can be read with
+ *        shtc3_read_measurement() after SHTC3_MEAS_TIME_NM_US
+ *
+ * @param me : Pointer to a shtc3_t instance
+ *
+ * @return 0 on success
+ */
+int shtc3_start_measurement(shtc3_t *const me);
+
+/**
+ * @brief Function to read the temperature (°C) and humidity (%) of the
+ *        measurement triggered by shtc3_start_measurement()
+ *
+ * @param me   : Pointer to a shtc3_t instance
+ * @param temp : Pointer to floating point value, where the calculated
+ *               temperature value will be stored
+ * @param hum  : Pointer to floating point value, where the calculated
+ *               humidity value will be stored
+ *
+ * @return 0 on success, non-zero if the measurement is not ready yet or the
+ *         CRC does not match
+ */
+int shtc3_read_measurement(shtc3_t *const me, float *temp, float *hum);
+
 /**
  * @brief Function to put the device in sleep mode
  *
@@ -0,0 +1,39 @@
+/**
+  ******************************************************************************
+  * @file           : shtc3_sensor.h
+  * @brief          : SHTC3 adapter for the generic sensor interface
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SHTC3_SENSOR_H_
+#define SHTC3_SENSOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "shtc3.h"
+#include "neo_sensor.h"
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+ * @brief Function to expose a SHTC3 instance through the generic sensor
+ *        interface. start() wakes the device and triggers a normal mode
+ *        measurement, fetch() returns a temperature and a humidity record and
+ *        sleep() puts the device in sleep mode
+ *
+ * @param me     : Pointer to an initialized shtc3_t instance
+ * @param id     : Identifier stamped on the produced samples
+ * @param sensor : Pointer to the generic sensor to fill
+ */
+void shtc3_sensor_bind(shtc3_t *const me, uint8_t id, neo_sensor_t *sensor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHTC3_SENSOR_H_ */
+
+/***************************** END OF FILE ************************************/
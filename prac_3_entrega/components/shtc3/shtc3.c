@@ -117,16 +117,11 @@ int shtc3_init(shtc3_t *const me, void *i2c_handle, uint8_t dev_addr)
 	int ret = 0;
 
 #ifdef ESP32_TARGET
-	/* Add device to I2C bus */
-	i2c_device_config_t i2c_dev_conf = {
-			.scl_speed_hz = 400000,
-			.device_address = dev_addr
-	};
-
-	if (i2c_master_bus_add_device((i2c_master_bus_handle_t)i2c_handle,
-			&i2c_dev_conf, &me->i2c_dev.handle) != 0) {
+	/* Add device to the shared I2C bus */
+	if (neo_i2c_add_device((i2c_master_bus_handle_t)i2c_handle, "shtc3",
+			dev_addr, 400000, &me->i2c_dev.handle) != 0) {
 		ESP_LOGE(TAG, "Failed to add device to I2C bus");
-		return ret;
+		return -1;
 	}
 #else
 	me->i2c_dev.handle = (I2C_HandleTypeDef *)i2c_handle;
@@ -243,6 +238,50 @@ int shtc3_get_temp_and_hum_polling(shtc3_t *const me, float *temp, float *hum)
 	return ret;
 }
 
+/**
+ * @brief Function to wake up the device and trigger a measurement without
+ *        clock stretching
+ */
+int shtc3_start_measurement(shtc3_t *const me)
+{
+	shtc3_wakeup(me);
+
+	if (shtc3_reg_write(SHTC3_CMD_MEAS_T_RH_POLLING_NM, &me->i2c_dev) != 0) {
+		return -1;
+	}
+
+	/* Return 0 */
+	return 0;
+}
+
+/**
+ * @brief Function to read the result of shtc3_start_measurement()
+ */
+int shtc3_read_measurement(shtc3_t *const me, float *temp, float *hum)
+{
+	uint8_t data[6] = {0};
+
+	/* The device NACKs the read while the conversion is still running */
+	if (shtc3_reg_read(data, 6, &me->i2c_dev) != 0) {
+		return -1;
+	}
+
+	/* Check data received CRC */
+	if (!check_crc(&data[0], 2, data[2])) {
+		return -1;
+	}
+
+	if (!check_crc(&data[3], 2, data[5])) {
+		return -1;
+	}
+
+	*temp = calc_temp((uint16_t)((data[0] << 8) | (data[1])));
+	*hum = calc_hum((uint16_t)((data[3] << 8) | (data[4])));
+
+	/* Return 0 */
+	return 0;
+}
+
 /**
  * @brief Function to put the device in sleep mode
  */
@@ -296,7 +335,7 @@ static int8_t shtc3_reg_read(uint8_t *data, uint32_t data_len, void *intf)
 	shtc3_i2c_t *i2c_dev = (shtc3_i2c_t *)intf;
 
 #ifdef ESP32_TARGET
-	if (i2c_master_receive(i2c_dev->handle, data, data_len, -1)
+	if (neo_i2c_receive(i2c_dev->handle, data, data_len, -1)
 			!= 0) {
 		return -1;
 	}
@@ -324,7 +363,7 @@ static int8_t shtc3_reg_write(uint16_t data, void *intf)
 	shtc3_i2c_t *i2c_dev = (shtc3_i2c_t *)intf;
 
 #ifdef ESP32_TARGET
-	if (i2c_master_transmit(i2c_dev->handle, buffer, 2, -1)
+	if (neo_i2c_transmit(i2c_dev->handle, buffer, 2, -1)
 			!= 0) {
 		return -1;
 	}
@@ -0,0 +1,64 @@
+/**
+  ******************************************************************************
+  * @file           : shtc3_sensor.c
+  * @brief          : SHTC3 adapter for the generic sensor interface
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "shtc3_sensor.h"
+
+/* Private function definitions ----------------------------------------------*/
+static esp_err_t shtc3_sensor_start(neo_sensor_t *sensor)
+{
+	return shtc3_start_measurement((shtc3_t *)sensor->ctx) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t shtc3_sensor_fetch(neo_sensor_t *sensor, neo_sample_t *samples,
+		size_t max_samples, size_t *count)
+{
+	float temp, hum;
+
+	if (max_samples < 2) {
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	if (shtc3_read_measurement((shtc3_t *)sensor->ctx, &temp, &hum) != 0) {
+		return ESP_FAIL;
+	}
+
+	samples[0] = (neo_sample_t) { .kind = NEO_SAMPLE_TEMPERATURE, .value = { temp } };
+	samples[1] = (neo_sample_t) { .kind = NEO_SAMPLE_HUMIDITY, .value = { hum } };
+	*count = 2;
+
+	return ESP_OK;
+}
+
+static esp_err_t shtc3_sensor_sleep(neo_sensor_t *sensor)
+{
+	return shtc3_sleep((shtc3_t *)sensor->ctx) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static const neo_sensor_ops_t shtc3_sensor_ops = {
+	.start = shtc3_sensor_start,
+	.fetch = shtc3_sensor_fetch,
+	.sleep = shtc3_sensor_sleep,
+};
+
+/* Exported functions definitions --------------------------------------------*/
+/**
+ * @brief Function to expose a SHTC3 instance through the generic sensor
+ *        interface
+ */
+void shtc3_sensor_bind(shtc3_t *const me, uint8_t id, neo_sensor_t *sensor)
+{
+	*sensor = (neo_sensor_t) {
+		.ops = &shtc3_sensor_ops,
+		.name = "shtc3",
+		.ctx = me,
+		.conversion_us = SHTC3_MEAS_TIME_NM_US,
+		.id = id,
+	};
+}
+
+/***************************** END OF FILE ************************************/
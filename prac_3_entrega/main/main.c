@@ -1,8 +1,10 @@
 #include <stdio.h>
 #include "shtc3.h"
+#include "shtc3_sensor.h"
+#include "neo_sensor_sched.h"
 #include "esp_event.h"
 #include "esp_log.h"
-#include "driver/i2c.h"
+#include "neo_i2c.h"
 
 #include "mock_wifi.h"
 #include "mock_flash.h"
@@ -22,44 +24,34 @@ QueueHandle_t xQueue = NULL;
 static const char *TAG = "example_of_group_3";  //i guess not so sure
 
 shtc3_t tempSensor;
+neo_sensor_t tempSensorIf;
 i2c_master_bus_handle_t bus_handle;
 
 void init_i2c(void) {
     //uint16_t id;
-    i2c_master_bus_config_t i2c_bus_config = {
-        .clk_source = I2C_CLK_SRC_DEFAULT,
-        .i2c_port = I2C_NUM_0,
-        .scl_io_num = 8,
-        .sda_io_num = 10,
-        .glitch_ignore_cnt = 7,
-        .flags.enable_internal_pullup = true,
-    };
-
-    ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_bus_config, &bus_handle));
+    ESP_ERROR_CHECK(neo_i2c_bus_get(I2C_NUM_0, CONFIG_I2C_SCL_GPIO, CONFIG_I2C_SDA_GPIO, &bus_handle));
 
     shtc3_init(&tempSensor, bus_handle, 0x70);
 }
 
-void sensor(void * pvParameters){
-    float ticks = *((float *) pvParameters);
-
-    while (1){
-        if (data_connection) {
-            size_t data_in_flash = getDataLeft();
-            while(data_in_flash>0){
-                temp = readFloatFromFlash(precision);
-                hum = readFloatFromFlash(precision);
-                ESP_LOGI(TAG, "Temp is %f and hum is %f", temp, hum);
-                data_in_flash = getDataLeft();
-            }
-            shtc3_get_temp_and_hum(&tempSensor, &temp, &hum);
-            ESP_LOGI(TAG, "Temp is %f and hum is %f", temp, hum);
-        } else {
-            shtc3_get_temp_and_hum(&tempSensor, &temp, &hum);
-            writeToFlash(&temp, precision);
-            writeToFlash(&hum, precision);
+void sensor(const neo_sample_t *samples, size_t count, void *arg){
+    for (size_t i = 0; i < count; i++) {
+        if (samples[i].kind == NEO_SAMPLE_TEMPERATURE) temp = samples[i].value[0];
+        if (samples[i].kind == NEO_SAMPLE_HUMIDITY) hum = samples[i].value[0];
+    }
+
+    if (data_connection) {
+        size_t data_in_flash = getDataLeft();
+        while(data_in_flash>0){
+            float old_temp = readFloatFromFlash(precision);
+            float old_hum = readFloatFromFlash(precision);
+            ESP_LOGI(TAG, "Temp is %f and hum is %f", old_temp, old_hum);
+            data_in_flash = getDataLeft();
         }
-        vTaskDelay(pdMS_TO_TICKS(ticks));
+        ESP_LOGI(TAG, "Temp is %f and hum is %f", temp, hum);
+    } else {
+        writeToFlash(&temp, precision);
+        writeToFlash(&hum, precision);
     }
 }
 
@@ -102,9 +94,15 @@ void app_main(void)
 
     mock_flash_init(capacity);
 
-    TaskHandle_t sensor_handle;
-
-    xTaskCreate(sensor, "PeriodicTask", 2048, &time, 5, &sensor_handle);
+    neo_sched_handle_t sensor_sched;
+    const neo_sched_config_t sched_cfg = {
+        .sink = sensor,
+        .jitter_ms = 10,
+    };
+    shtc3_sensor_bind(&tempSensor, 0, &tempSensorIf);
+    ESP_ERROR_CHECK(neo_sched_create(&sched_cfg, &sensor_sched));
+    ESP_ERROR_CHECK(neo_sched_add(sensor_sched, &tempSensorIf, 1000 * CONFIG_PERIOD_N));
+    ESP_ERROR_CHECK(neo_sched_start(sensor_sched));
 
     esp_event_loop_handle_t loop;
     esp_event_loop_args_t loop_args = {
@@ -145,8 +143,9 @@ void app_main(void)
 
     wifi_disconnect();
 
-    vTaskSuspend(sensor_handle);
-    vTaskDelete(sensor_handle);
+    neo_sched_delete(sensor_sched);
+
+    neo_i2c_bus_release(bus_handle);
 
     mock_flash_destroy();
 